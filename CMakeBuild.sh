@@ -1,12 +1,14 @@
 #!/bin/bash
-#CMakeBuild.sh [ALL,ACTIVE] [DEBUG, ASAN, OPTIMIZED] [PATH TO .cpp] [.cpp BASENAME]
+#CMakeBuild.sh [ALL,ACTIVE] [DEBUG, ASAN, OPTIMIZED] [PATH TO .cpp] [.cpp BASENAME] [HEADLESS]
 BUILD="${1:-ALL}" #ALL builds every .cpp source in SRC_DIR. ACTIVE builds single source ${PROG}.cpp
 TYPE="${2:-OPTIMIZED}" #Type of build: DEBUG, ASAN, OPTIMIZED. GCC debug/optimization flags
 SRC_DIR="${3:-./src}" #path to .cpp source. Uses ./include as .hpp directory
 PROG="${4:-kaelifecpp}" #Base name of .cpp file if using ACTIVE.
+HEADLESS="${5:+ON}" #Any 5th argument builds without SDL2, OpenGL and GLEW. Sources must not include them
+HEADLESS="${HEADLESS:-OFF}"
 CONFIG=./CMakeLists.txt
 
-echo cmake "${CONFIG} -DBUILD="${BUILD}" -DTYPE="${TYPE}" -DSRC_DIR="${SRC_DIR}" -DPROG="${PROG}
-cmake "${CONFIG}" -DBUILD="${BUILD}" -DTYPE="${TYPE}" -DSRC_DIR="${SRC_DIR}" -DPROG="${PROG}"
+echo cmake "${CONFIG} -DBUILD="${BUILD}" -DTYPE="${TYPE}" -DSRC_DIR="${SRC_DIR}" -DPROG="${PROG}" -DHEADLESS="${HEADLESS}
+cmake "${CONFIG}" -DBUILD="${BUILD}" -DTYPE="${TYPE}" -DSRC_DIR="${SRC_DIR}" -DPROG="${PROG}" -DHEADLESS="${HEADLESS}"
 
 make #VERBOSE=1
@@ -0,0 +1,153 @@
+/**
+ * @file kaelifeHeadless.cpp
+ *
+ * @brief Batch simulation without window. Iterates a seeded world on every core and prints throughput
+ *
+ * Only CAData is included, so SDL2, GLEW and OpenGL are neither included nor linked.
+ * Build: sh CMakeBuild.sh ALL OPTIMIZED ./headless kaelifeHeadless HEADLESS
+ * Run: ./build/kaelifeHeadless_OPTIMIZED [--rows X] [--cols Y] [--gens N] [--preset I] [--seed S] [--threads T] [--kernel K] [--temporal D] [--task G] [--bits B] [--numa on|off] [--max-mib M] [--out world.pgm]
+ * --bits 16 runs CAData16, which also lists the presets that need more than 256 states
+ * --max-mib caps one world buffer, bigger worlds are halved until they fit. Default is an eighth of physical memory
+ * --numa pins threads and places their stripes on their nodes. Default is on if the machine has more than one NUMA node
+*/
+
+#include "kaelRandom.hpp" //Randomizers and Hashers
+namespace kaelife {
+	KaelRandom<uint64_t>rand; //global randomizer kaelife::rand()
+	constexpr bool CA_DEBUG = 0; //Enable debugging for CA related classes
+	constexpr bool INPUT_DEBUG = 0; //No InputHandler in headless
+}
+
+#include "CA/kaelifeCAData.hpp" //CA simulation iterator
+#include "kaelifeBMPIO.hpp" //world export
+
+#include <iostream>
+#include <cstring>
+#include <chrono>
+
+struct HeadlessArgs{
+	uint rows = CAData::defaultRows;
+	uint cols = CAData::defaultCols;
+	uint64_t generations = 1000;
+	uint preset = 0;
+	uint64_t seed = 12345;
+	uint threads = 0; //0 uses every core
+	int kernel = CAKernel::KERNEL_AUTO;
+	uint temporalDepth = 1;
+	uint taskSize = 100; //generations per continueThread
+	uint bits = 8; //cell width, 8 or 16
+	int numa = -1; //-1 keeps the CAData default, 0 off, 1 on
+	uint64_t maxMiB = 0; //0 keeps the CAData default
+	const char* outPath = nullptr;
+};
+
+void printUsage(const char* prog){
+	printf("Usage: %s [--rows X] [--cols Y] [--gens N] [--preset I] [--seed S] [--threads T] [--kernel K] [--temporal D] [--task G] [--bits 8|16] [--numa on|off] [--max-mib M] [--out world.pgm]\n", prog);
+	printf("  kernels:");
+	for(uint k=0;k<CAKernel::KERNEL_COUNT;k++){
+		printf(" %u=%s", k, CAKernel::kernelName[k]);
+	}
+	printf("\n");
+}
+
+//false if an option is unknown or lacks value
+bool parseArgs(int argc, char** argv, HeadlessArgs &args){
+	for(int i=1;i<argc;i++){
+		if(i+1>=argc){ return false; } //every option takes a value
+		const char* key = argv[i];
+		const char* value = argv[++i];
+		if		(!strcmp(key, "--rows"		)){ args.rows			= strtoul(value, nullptr, 10); }
+		else if	(!strcmp(key, "--cols"		)){ args.cols			= strtoul(value, nullptr, 10); }
+		else if	(!strcmp(key, "--gens"		)){ args.generations	= strtoull(value, nullptr, 10); }
+		else if	(!strcmp(key, "--preset"	)){ args.preset			= strtoul(value, nullptr, 10); }
+		else if	(!strcmp(key, "--seed"		)){ args.seed			= strtoull(value, nullptr, 10); }
+		else if	(!strcmp(key, "--threads"	)){ args.threads		= strtoul(value, nullptr, 10); }
+		else if	(!strcmp(key, "--kernel"	)){ args.kernel			= strtol(value, nullptr, 10); }
+		else if	(!strcmp(key, "--temporal"	)){ args.temporalDepth	= std::max<uint>(strtoul(value, nullptr, 10), 1); }
+		else if	(!strcmp(key, "--task"		)){ args.taskSize		= std::max<uint>(strtoul(value, nullptr, 10), 1); }
+		else if	(!strcmp(key, "--bits"		)){ args.bits			= strtoul(value, nullptr, 10); }
+		else if	(!strcmp(key, "--numa"		)){ args.numa			= !strcmp(value, "on") ? 1 : !strcmp(value, "off") ? 0 : -2; }
+		else if	(!strcmp(key, "--max-mib"	)){ args.maxMiB			= strtoull(value, nullptr, 10); }
+		else if	(!strcmp(key, "--out"		)){ args.outPath		= value; }
+		else{ return false; }
+	}
+	return args.kernel>=0 && args.kernel<CAKernel::KERNEL_COUNT && (args.bits==8 || args.bits==16) && args.numa>=-1;
+}
+
+//FNV-1a of world cells, equal worlds print equal hashes for either cell width
+template<typename Cell>
+uint64_t hashWorld(const CAGrid<Cell> &grid){
+	uint64_t hash = 1469598103934665603ull;
+	for(size_t x=0;x<grid.getRows();x++){
+		for(size_t y=0;y<grid.getCols();y++){
+			hash = (hash^grid[x][y])*1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+template<typename Cell>
+int runWorld(HeadlessArgs &args){
+	CADataT<Cell> kaeData(args.rows, args.cols, args.maxMiB<<20);
+	if(kaeData.kaePreset.setPreset(args.preset)!=args.preset){
+		printf("No preset %u\n", args.preset);
+		return 1;
+	}
+	kaeData.kernelPreference = (CAKernel::KernelType)args.kernel;
+	kaeData.mainCache.temporalDepth = args.temporalDepth;
+	kaeData.loadPreset();
+	kaeData.randState(kaeData.mainCache.stateCount, &args.seed);
+	kaeData.cloneBuffer();
+	if(args.numa>=0){
+		kaeData.setNumaPlacement(args.numa); //threads read it when they start
+	}
+
+	std::vector<std::thread> iterThreads;
+	std::thread iterHandler = std::thread([&]() {
+		kaeData.startWorkerThreads(iterThreads);
+	});
+	kaeData.syncMainThread();
+	if(args.threads){
+		kaeData.setThreadCount(args.threads); //threads copy the count with the next task
+	}
+
+	printf("%ux%u world, preset %s, kernel %s -> %s, %u/%u threads, %u per tile, %lu-bit cells, NUMA %s\n", kaeData.mainCache.tileRows, kaeData.mainCache.tileCols,
+		kaeData.kaePreset.current()->name.c_str(), CAKernel::kernelName[kaeData.kernelPreference], CAKernel::kernelName[kaeData.mainCache.kernel],
+		kaeData.mainCache.threadCount, kaeData.poolSize, kaeData.mainCache.temporalDepth, sizeof(Cell)*8, kaeData.numaPlacement ? "on" : "off");
+
+	auto start = std::chrono::steady_clock::now();
+	for(uint64_t done=0;done<args.generations;){
+		const uint iterTask = std::min<uint64_t>(args.taskSize, args.generations-done);
+		kaeData.kaeMutex.continueThread(iterTask, kaeData.mainCache.activeBuf);
+		kaeData.syncMainThread();
+		done += iterTask;
+		kaeData.generation += iterTask;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	const double ms = std::chrono::duration<double, std::milli>(end-start).count();
+	const double cells = (double)kaeData.mainCache.tileRows*kaeData.mainCache.tileCols*args.generations;
+	printf("%lu generations %.2f ms %.1f gen/s %.2f Mcell/s hash %016lx\n", (uint64_t)kaeData.generation, ms,
+		ms>0 ? args.generations*1000.0/ms : 0.0, ms>0 ? cells/ms/1000.0 : 0.0, hashWorld(kaeData.cellState[kaeData.mainCache.activeBuf]));
+	kaeData.printThreadTiming();
+	if(kaeData.mainCache.kernel==CAKernel::KERNEL_CHUNKED){
+		printf("%lu chunks %lu KiB\n", kaeData.chunks.chunkCount(), kaeData.chunks.chunkBytes()/1024);
+	}
+
+	kaeData.kaeMutex.terminateThread();
+	iterHandler.join();
+
+	if(args.outPath && !kaelife::exportPGM(kaeData, args.outPath)){
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	HeadlessArgs args;
+	if(!parseArgs(argc, argv, args)){
+		printUsage(argv[0]);
+		return 1;
+	}
+	return args.bits==16 ? runWorld<uint16_t>(args) : runWorld<uint8_t>(args);
+}
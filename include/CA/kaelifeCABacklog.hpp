@@ -6,7 +6,6 @@
 
 #pragma once
 
-#include "kaelife.hpp"
 #include "CA/kaelifeCAPreset.hpp"
 #include "CA/kaelifeCACache.hpp"
 #include "CA/kaelifeCADraw.hpp"
@@ -23,19 +22,22 @@
 
 /**
  * @brief Backlog thread critical tasks and execute them later
+ *
+ * @tparam Cell cell type of the CADataT that runs the tasks
 */
-class CABacklog {
+template<typename Cell>
+class CABacklogT {
 public:
-	CABacklog(CAData& inCaData);
+	CABacklogT(CADataT<Cell>& inCaData);
 
-	void doBacklog();
+	bool doBacklog();
 	void add(const char* keyword);
 
 private:
 	/**
 	 * @brief function wrapper
 	*/
-	typedef bool (CABacklog::*CAB_func)();
+	typedef bool (CABacklogT::*CAB_func)();
 
 	/**
 	 * @brief map valid backlog tasks const char* to corresponding function
@@ -48,8 +50,8 @@ private:
 	std::mutex mtx;
 	std::vector<const char*> list; // tasks to do that are not thread safe
 
-	CAData& caData;
-	CAPreset& kaePreset;
+	CADataT<Cell>& caData;
+	CAPresetT<Cell>& kaePreset;
 	CADraw& kaeDraw;
 
 	bool CAB_cloneBuffer();
@@ -60,16 +62,30 @@ private:
 	bool CAB_randRange();
 	bool CAB_randMask();
 	bool CAB_randMutate();
+	bool CAB_nextKernel();
+	bool CAB_nextTemporalDepth();
+	bool CAB_lessThreads();
+	bool CAB_moreThreads();
+	bool CAB_growWorld();
+	bool CAB_shrinkWorld();
+	bool CAB_toggleNuma();
 
 	std::vector<funcMap> keywordMap = {
-		{"cloneBuffer", &CABacklog::CAB_cloneBuffer	},
-		{"loadPreset", 	&CABacklog::CAB_loadPreset	},
-		{"cursorDraw", 	&CABacklog::CAB_cursorDraw	},
-		{"randAll", 	&CABacklog::CAB_randAll		},
-		{"randAdd", 	&CABacklog::CAB_randAdd		},
-		{"randRange", 	&CABacklog::CAB_randRange	},
-		{"randMask", 	&CABacklog::CAB_randMask	},
-		{"randMutate", 	&CABacklog::CAB_randMutate	}
+		{"cloneBuffer", &CABacklogT::CAB_cloneBuffer	},
+		{"loadPreset", 	&CABacklogT::CAB_loadPreset	},
+		{"cursorDraw", 	&CABacklogT::CAB_cursorDraw	},
+		{"randAll", 	&CABacklogT::CAB_randAll		},
+		{"randAdd", 	&CABacklogT::CAB_randAdd		},
+		{"randRange", 	&CABacklogT::CAB_randRange	},
+		{"randMask", 	&CABacklogT::CAB_randMask	},
+		{"randMutate", 	&CABacklogT::CAB_randMutate	},
+		{"nextKernel", 	&CABacklogT::CAB_nextKernel	},
+		{"nextTemporalDepth", &CABacklogT::CAB_nextTemporalDepth},
+		{"lessThreads", &CABacklogT::CAB_lessThreads	},
+		{"moreThreads", &CABacklogT::CAB_moreThreads	},
+		{"growWorld", 	&CABacklogT::CAB_growWorld	},
+		{"shrinkWorld", &CABacklogT::CAB_shrinkWorld	},
+		{"toggleNuma", 	&CABacklogT::CAB_toggleNuma	}
 	};
 };
 
@@ -79,8 +95,9 @@ private:
  * 
  * @param inCaData CAData reference
 */
-CABacklog::CABacklog(
-		CAData& inCaData
+template<typename Cell>
+CABacklogT<Cell>::CABacklogT(
+		CADataT<Cell>& inCaData
 	) : 
 		caData(inCaData),
 		kaePreset(inCaData.kaePreset),
@@ -88,19 +105,23 @@ CABacklog::CABacklog(
 
 //Functions
 //Each function returns boolean wether cloneBuffer needs to be called
-bool CABacklog::CAB_cloneBuffer(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_cloneBuffer(){
 	return true;
 }
-bool CABacklog::CAB_loadPreset(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_loadPreset(){
 	caData.loadPreset();
 	kaePreset.printPreset();
 	return true;
 }
-bool CABacklog::CAB_cursorDraw(){
-	bool didCopy = kaeDraw.copyDrawBuf(caData.cellState[!caData.mainCache.activeBuf], caData.mainCache); 
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_cursorDraw(){
+	bool didCopy = kaeDraw.copyDrawBuf(caData.cellState[caData.mainCache.activeBuf], caData.mainCache); 
 	return didCopy;
 }
-bool CABacklog::CAB_randAll(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_randAll(){
 	auto copyIndex = kaePreset.copyPreset((std::string)"RANDOM",kaePreset.index);
 	kaePreset.setPreset(copyIndex[0]);
 	uint64_t randSeed = kaePreset.randAll(copyIndex[0]);
@@ -110,7 +131,8 @@ bool CABacklog::CAB_randAll(){
 	printf("RANDOM seed: %lu\n",(uint64_t)randSeed);
 	return true;
 }
-bool CABacklog::CAB_randAdd(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_randAdd(){
 	auto copyIndex = kaePreset.copyPreset((std::string)"RANDOM",kaePreset.index);
 	kaePreset.setPreset(copyIndex[0]);
 	kaePreset.randRuleAdd(kaePreset.index);
@@ -118,7 +140,8 @@ bool CABacklog::CAB_randAdd(){
 	kaePreset.printRuleAdd(kaePreset.index);
 	return true;
 }
-bool CABacklog::CAB_randRange(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_randRange(){
 	auto copyIndex = kaePreset.copyPreset((std::string)"RANDOM",kaePreset.index);
 	kaePreset.setPreset(copyIndex[0]);
 	kaePreset.randRuleRange(kaePreset.index,0);
@@ -126,7 +149,8 @@ bool CABacklog::CAB_randRange(){
 	kaePreset.printRuleRange(kaePreset.index);	
 	return true;
 }
-bool CABacklog::CAB_randMask(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_randMask(){
 	auto copyIndex = kaePreset.copyPreset((std::string)"RANDOM",kaePreset.index);
 	kaePreset.setPreset(copyIndex[0]);
 	kaePreset.randRuleMask(kaePreset.index);
@@ -134,7 +158,8 @@ bool CABacklog::CAB_randMask(){
 	kaePreset.printRuleMask(kaePreset.index);
 	return true;
 }
-bool CABacklog::CAB_randMutate(){
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_randMutate(){
 	auto copyIndex = kaePreset.copyPreset((std::string)"RANDOM",kaePreset.index);
 	kaePreset.setPreset(copyIndex[0]);
 	kaePreset.randRuleMutate(kaePreset.index);
@@ -144,13 +169,61 @@ bool CABacklog::CAB_randMutate(){
 	return true;
 }
 
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_nextKernel(){
+	uint kernel = caData.nextKernel();
+	printf("Kernel: %s -> %s, SIMD: %s\n", 
+		CAKernel::kernelName[caData.kernelPreference], CAKernel::kernelName[kernel], CAKernel::simdName[CAKernel::simdLevel()]);
+	return false;
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_nextTemporalDepth(){
+	printf("Generations per tile: %u\n", caData.nextTemporalDepth());
+	return false;
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_lessThreads(){
+	printf("Threads: %u/%u\n", caData.setThreadCount(caData.mainCache.threadCount-1), caData.poolSize);
+	return false;
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_moreThreads(){
+	printf("Threads: %u/%u\n", caData.setThreadCount(caData.mainCache.threadCount+1), caData.poolSize);
+	return false;
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_growWorld(){
+	if(caData.resizeWorld(caData.mainCache.tileRows*2, caData.mainCache.tileCols*2)){ //refuses worlds over maxWorldBytes
+		printf("World: %ux%u\n", caData.mainCache.tileRows, caData.mainCache.tileCols);
+	}
+	return false; //resizeWorld publishes the cells
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_shrinkWorld(){
+	caData.resizeWorld(std::max(caData.mainCache.tileRows/2, caData.blockRows), std::max(caData.mainCache.tileCols/2, caData.blockCols));
+	printf("World: %ux%u\n", caData.mainCache.tileRows, caData.mainCache.tileCols);
+	return false;
+}
+
+template<typename Cell>
+bool CABacklogT<Cell>::CAB_toggleNuma(){
+	printf("NUMA placement: %d, %u nodes\n", caData.setNumaPlacement(!caData.numaPlacement), caData.numa.nodeCount());
+	return false;
+}
+
 
 /**
  * @brief add task to backlog
  * 
  * @param keyword Must be valid const char* in keywordMap
 */
-void CABacklog::add(const char* keyword) {
+template<typename Cell>
+void CABacklogT<Cell>::add(const char* keyword) {
 	std::lock_guard<std::mutex> lock(mtx);
 
 	// Check if already backlogged
@@ -163,13 +236,16 @@ void CABacklog::add(const char* keyword) {
 /**
  * @brief execute before cloneBuffer not-thread safe functions backlog
  * 
- * @note writes must happen in !activeBuf
+ * @note writes must happen in activeBuf
+ * 
+ * @return whether any task was executed
 */
-void CABacklog::doBacklog() {
+template<typename Cell>
+bool CABacklogT<Cell>::doBacklog() {
 	std::lock_guard<std::mutex> lock(mtx);
 
 	if (list.empty()) {
-		return;
+		return false;
 	}
 
 	// Flag to prevent cloning buffer every single keyword
@@ -191,7 +267,7 @@ void CABacklog::doBacklog() {
 			printf("Invalid backlog key!\n");
 			continue;
 		}
-		cloneBufferRequest = (this->*selectedFunction)();
+		cloneBufferRequest |= (this->*selectedFunction)();
 
 	}while (!list.empty());
 
@@ -200,4 +276,5 @@ void CABacklog::doBacklog() {
 	if (cloneBufferRequest) {
 		caData.cloneBuffer();
 	}
+	return true;
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+/**
+ * @file kaelifeCABitEngine.hpp
+ *
+ * @brief CAData bit packed iteration for 2 state presets
+*/
+
+#pragma once
+
+#include "kaelifeCACache.hpp"
+#include "kaelifeCAGrid.hpp"
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <atomic>
+
+/**
+ * @brief Bit sliced 2 state automata. One bit per cell, 64 cells per word along Y axis
+ *
+ * Works for presets with 2 states and a mask of at most 3x3 where every weight is 0 or 255,
+ * then the neighbor sum is a count of live cells and the rule is a truth table of the count and cell.
+ * The count is built with a bitwise adder network so each operation handles 64 cells.
+ *
+ * Packed world is kept for a whole iteration task. Threads pack their stripe of cellState at task start,
+ * iterate packed stripes and unpack them back to both cellState buffers at task end
+*/
+class CABitEngine {
+public:
+	CABitEngine() {}
+
+	/**
+	 * @brief Whether preset in cache can be packed. Cell values are checked separately by packRows
+	*/
+	static bool fits(const CACache::ThreadCache &cache) {
+		if(cache.stateCount!=2){ return 0; }
+		if(cache.maskWidth>3 || cache.maskHeight>3){ return 0; }
+		for(const uint8_t weight : cache.neigMask1d){
+			if(weight!=0 && weight!=UINT8_MAX){ return 0; }
+		}
+		return 1;
+	}
+
+	/**
+	 * @brief Compile mask and rules of a fitting preset to bitTaps, bitBirth and bitSurvive
+	 *
+	 * @param cache mainCache with loaded neigMask1d and ruleNext
+	*/
+	static void compileRules(CACache::ThreadCache &cache) {
+		cache.bitTaps = 0;
+		cache.bitBirth = 0;
+		cache.bitSurvive = 0;
+		if(!fits(cache)){ return; }
+
+		if(cache.clipTreshold<=1){ //clip above 1 discards every neighbor
+			for(uint i=0;i<cache.maskElements;++i){
+				if(cache.neigMask1d[i]==0){continue;}
+				int x=i%cache.maskWidth-cache.maskRadx;
+				int y=i/cache.maskWidth-cache.maskRady;
+				cache.bitTaps |= 1 << ((x+1)*3+(y+1));
+			}
+		}
+
+		uint maxCount = __builtin_popcount(cache.bitTaps);
+		for(uint count=0;count<=maxCount;++count){
+			const uint8_t* next = &cache.ruleNext[cache.ruleOffset[count]];
+			cache.bitBirth   |= (next[0]==1) << count;
+			cache.bitSurvive |= (next[1]==1) << count;
+		}
+	}
+
+	/**
+	 * @brief Allocate both packed worlds. Not thread safe
+	*/
+	void resize(const size_t newRows, const size_t newCols) {
+		if(newRows==rows && newCols==cols){ return; }
+		rows = newRows;
+		cols = newCols;
+		words = (cols+63)/64;
+		lastMask = cols%64 ? (1ULL<<(cols%64))-1 : ~0ULL;
+		for(int j=0;j<2;j++){
+			packed[j].assign(rows*words, 0);
+		}
+	}
+
+	/**
+	 * @brief Pack rows [x0,x1) of grid to packed[buf]
+	 *
+	 * @return false if any cell is not 0 or 1. Then nothing should be iterated from packed[buf]
+	*/
+	bool packRows(const CAGrid<uint8_t> &grid, const bool buf, const size_t x0, const size_t x1) {
+		uint8_t orCells = 0;
+		for(size_t x=x0;x<x1;++x){
+			const uint8_t* src = grid[x];
+			uint64_t* dst = &packed[buf][x*words];
+			for(size_t w=0;w<words;++w){
+				const size_t y0 = w*64;
+				const size_t n = std::min<size_t>(64, cols-y0);
+				uint64_t bits = 0;
+				for(size_t i=0;i<n;++i){
+					orCells |= src[y0+i];
+					bits |= (uint64_t)(src[y0+i]&1) << i;
+				}
+				dst[w] = bits;
+			}
+		}
+		return orCells<=1;
+	}
+
+	/**
+	 * @brief Unpack rows [x0,x1) of packed[buf] to both grids and refresh their halo
+	*/
+	void unpackRows(CAGrid<uint8_t> (&grids)[2], const bool buf, const size_t x0, const size_t x1) {
+		for(size_t x=x0;x<x1;++x){
+			const uint64_t* src = &packed[buf][x*words];
+			uint8_t* dst = grids[0][x];
+			for(size_t y=0;y<cols;++y){
+				dst[y] = (src[y/64] >> (y%64)) & 1;
+			}
+			std::memcpy(grids[1][x], dst, cols);
+			grids[0].refreshRowHalo(x);
+			grids[1].refreshRowHalo(x);
+		}
+	}
+
+	/**
+	 * @brief Iterate rows [x0,x1) from packed[srcBuf] to packed[!srcBuf]
+	 *
+	 * Reads rows x0-1 and x1 too, so neighboring stripes must be done with srcBuf
+	*/
+	void iterateRows(const CACache::ThreadCache &lv, const bool srcBuf, const size_t x0, const size_t x1) {
+		const uint64_t* src = packed[srcBuf].data();
+		uint64_t* dst = packed[!srcBuf].data();
+		for(size_t x=x0;x<x1;++x){
+			const uint64_t* rowPtr[3] = { //x-1, x, x+1 wrapped
+				&src[((x+rows-1)%rows)*words],
+				&src[x*words],
+				&src[((x+1)%rows)*words]
+			};
+			for(size_t w=0;w<words;++w){
+				uint64_t c0=0, c1=0, c2=0, c3=0; //bit sliced neighbor count
+				for(uint r=0;r<3;r++){
+					const uint taps = lv.bitTaps >> (r*3);
+					if((taps&7)==0){continue;}
+					uint64_t plane[3];
+					shiftedPlanes(rowPtr[r], w, plane);
+					for(uint k=0;k<3;k++){
+						if(!(taps>>k&1)){continue;}
+						//ripple add 1 bit plane to 4 bit counter
+						uint64_t carry = c0 & plane[k];
+						c0 ^= plane[k];
+						uint64_t carry1 = c1 & carry;
+						c1 ^= carry;
+						uint64_t carry2 = c2 & carry1;
+						c2 ^= carry1;
+						c3 |= carry2;
+					}
+				}
+
+				const uint64_t cell = rowPtr[1][w];
+				uint64_t next = 0;
+				for(uint count=0, rules=lv.bitBirth|lv.bitSurvive; rules; count++, rules>>=1){
+					if(!(rules&1)){continue;}
+					uint64_t match =
+						(count&1 ? c0 : ~c0) & (count&2 ? c1 : ~c1) &
+						(count&4 ? c2 : ~c2) & (count&8 ? c3 : ~c3);
+					uint64_t alive = 0;
+					alive |= (lv.bitBirth  >>count&1) ? ~cell : 0;
+					alive |= (lv.bitSurvive>>count&1) ?  cell : 0;
+					next |= match & alive;
+				}
+				dst[x*words+w] = w==words-1 ? next&lastMask : next;
+			}
+		}
+	}
+
+	/** @brief Set by packRows caller if any thread couldn't pack its stripe */
+	std::atomic<bool> unpackable = 0;
+
+private:
+	std::vector<uint64_t> packed[2];
+	size_t rows = 0;
+	size_t cols = 0;
+	size_t words = 0; //uint64_t per row
+	uint64_t lastMask = 0; //valid cells of last word in a row
+
+	/**
+	 * @brief Word w of row shifted to Y-1, Y and Y+1 neighbors. Wraps Y
+	*/
+	inline void shiftedPlanes(const uint64_t* row, const size_t w, uint64_t (&plane)[3]) const {
+		const uint lastBit = (cols-1)%64;
+		const uint64_t prev = w==0 ? row[words-1] >> lastBit : row[w-1] >> 63; //cell before bit 0
+		const uint64_t next = w==words-1 ? row[0] & 1 : row[w+1] & 1; //cell after last valid bit
+		const uint nextShift = w==words-1 ? lastBit : 63;
+		plane[0] = (row[w] << 1) | (prev & 1);
+		plane[1] = row[w];
+		plane[2] = (row[w] >> 1) | (next << nextShift);
+	}
+};
@@ -12,6 +12,9 @@
 #include <cmath>
 #include <limits>
 
+#include "kaelifeCAGrid.hpp"
+#include "kaelifeCACell.hpp"
+
 
 /**
  * @brief Unique thread cache of Cellular Autoamta variables
@@ -20,17 +23,71 @@ class CACache {
 public:
 	CACache() {}
 	
+	/**
+	 * @brief Non-zero neigMask element compiled for iteration
+	*/
+	struct MaskTap{
+		int32_t offset; //linear cellState offset from the iterated cell
+		uint8_t weight; //neigMask value
+		uint16_t table; //weightTables offset of this weight
+	};
+
+	/**
+	 * @brief neigMask elements of one weight that form a full rows*cols rectangle. Used by CAKernel box kernel
+	 *
+	 * Rows and columns don't need to be adjacent, e.g. mask corners form a 2*2 layer
+	*/
+	struct BoxLayer{
+		uint8_t weight; //neigMask value
+		std::vector<int32_t> rowOffsets; //x*tileStride of every layer row relative to mask center
+		std::vector<int16_t> cols; //y of every layer column relative to mask center. Ascending
+		bool centerHole; //rectangle includes the mask center which is not part of the layer
+	};
+
+	template<typename Cell> struct ThreadCacheT;
+	/**
+	 * @brief Thread cache of the default 8-bit world
+	*/
+	typedef ThreadCacheT<uint8_t> ThreadCache;
+	/**
+	 * @brief Row kernel iterating cells [y0,y1) of row tx, see CAKernel::iterateRow
+	*/
+	typedef bool (*RowKernel)(ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint tx, const uint y0, const uint y1);
+	/**
+	 * @brief Row kernel compiled by CAJit. Knows nothing of ThreadCache, so stride is passed
+	*/
+	typedef bool (*JitRowKernel)(const uint8_t* readBuf, uint8_t* writeBuf, ptrdiff_t stride, uint tx, uint y0, uint y1);
+
 	/**
 	 * @brief Unique cache data struct
+	 *
+	 * @tparam Cell cellState cell type. Kernel fields that only 8-bit kernels use stay empty for wider cells
 	*/
-	struct ThreadCache{
-		__attribute__((aligned(64))) std::vector<uint16_t> updatedCells[2];
+	template<typename Cell>
+	struct ThreadCacheT{
+		typedef CACellTraits<Cell> Traits;
+
 		__attribute__((aligned(64))) uint 				 threadId 		= -1; 
 		__attribute__((aligned(64))) uint 				 threadCount 	= -1;
 		__attribute__((aligned(64))) std::vector<uint8_t> neigMask1d  	= {}; //flattened neigMask
+		__attribute__((aligned(64))) std::vector<MaskTap> maskTaps  	= {}; //non-zero neigMask1d elements as cellState offsets
+		__attribute__((aligned(64))) std::vector<uint8_t> weightTables	= {}; //256 clipped cell*weight/255 products per distinct tap weight
+		__attribute__((aligned(64))) std::vector<BoxLayer> boxLayers	= {}; //neigMask as rectangle layers. Empty if the mask doesn't split to rectangles
+		__attribute__((aligned(64))) std::vector<typename Traits::Sum> boxScratch = {}; //box kernel row sums. Thread local, sized by copyCache for a whole row
+		__attribute__((aligned(64))) std::vector<uint8_t> fixedWeights	= {}; //neigMask zero padded to the fixed kernel mask size, X major
+		__attribute__((aligned(64))) RowKernel			 fixedRow		= nullptr; //fixed kernel instance for the mask size and state count. nullptr if none fits
+		__attribute__((aligned(64))) JitRowKernel		 jitRow			= nullptr; //CAJit kernel of the loaded preset. nullptr unless KERNEL_JIT is preferred and compiled
+		__attribute__((aligned(64))) CAGrid<Cell>		 tileScratch[2];	//temporal blocking tile, read [0] write [1]. Thread local, not copied
+		__attribute__((aligned(64))) uint				 temporalDepth	= 1; //generations per temporal blocking round. 1 iterates whole world every generation
+		__attribute__((aligned(64))) uint16_t			 bitTaps		= 0; //CABitEngine 3x3 mask bits, (x+1)*3+(y+1)
+		__attribute__((aligned(64))) uint16_t			 bitBirth		= 0; //CABitEngine bit n is set if dead cell with n neighbors becomes alive
+		__attribute__((aligned(64))) uint16_t			 bitSurvive		= 0; //CABitEngine bit n is set if alive cell with n neighbors stays alive
 		__attribute__((aligned(64))) bool				 activeBuf	 	= 0; //active cellState. write to !activeBuf read from activeBuf
-		__attribute__((aligned(64))) std::vector<int16_t> ruleRange	 	= {0}; //CA add ranges
-		__attribute__((aligned(64))) std::vector<int8_t>  ruleAdd	 	= {0,0}; //CA additive values within each range
+		__attribute__((aligned(64))) std::vector<typename Traits::Range> ruleRange = {0}; //CA add ranges
+		__attribute__((aligned(64))) std::vector<typename Traits::Add> ruleAdd = {0,0}; //CA additive values within each range
+		__attribute__((aligned(64))) std::vector<uint16_t> ruleOffset	= {0}; //neigsum to ruleNext row offset, or to rangeAdd index with 16-bit cells. Replaces ruleRange search
+		__attribute__((aligned(64))) std::vector<uint8_t> ruleNext	 	= {}; //ruleNext[ruleOffset[neigsum]+state] is the next clamped state. 8-bit cells only
+		__attribute__((aligned(64))) std::vector<int32_t> rangeAdd	 	= {}; //add of each ruleOffset index, last one past every range. Wider cells only
 		__attribute__((aligned(64))) uint	 			 stateCount	 	= {0}; //number of cell states
 		__attribute__((aligned(64))) uint8_t 			 maskWidth	 	= 0; //neigMask width
 		__attribute__((aligned(64))) uint8_t 			 maskHeight	 	= 0; //neigMask height
@@ -39,7 +96,9 @@ public:
 		__attribute__((aligned(64))) uint16_t 			 maskElements	= 0; //neigmask elements
 		__attribute__((aligned(64))) uint 			 	 tileRows	 	= 1; //wold space X dimension left to right. Can't be 0 or odd
 		__attribute__((aligned(64))) uint 			 	 tileCols	 	= 1; //wold space Y dimension down to up. Can't be 0 or odd
-		__attribute__((aligned(64))) uint8_t 			 clipTreshold	= 0; //CA rule to discard any neighbors below this value
+		__attribute__((aligned(64))) size_t 			 tileStride	 	= 1; //cellState row stride
+		__attribute__((aligned(64))) Cell	 			 clipTreshold	= 0; //CA rule to discard any neighbors below this value
+		__attribute__((aligned(64))) uint8_t 			 kernel			= 0; //CAKernel::KernelType used to iterate
 		__attribute__((aligned(64))) uint				 iterRepeats	= 0; //iteration thread task size
 		__attribute__((aligned(64))) size_t				 index		 	= 0; //cache incrementor to check if cache is up to date
 	};
@@ -50,13 +109,21 @@ public:
 	 * @param dst destination cache
 	 * @param src source cache
 	*/
-    void copyCache(ThreadCache *dst, const ThreadCache &src ) {
+	template<typename Cell>
+    void copyCache(ThreadCacheT<Cell> *dst, const ThreadCacheT<Cell> &src ) {
 		dst->ruleRange		=	src.ruleRange; 
 		dst->ruleAdd		=	src.ruleAdd;	 
+		dst->ruleOffset		=	src.ruleOffset;	 
+		dst->ruleNext		=	src.ruleNext;	 
+		dst->rangeAdd		=	src.rangeAdd;
 		dst->stateCount		=	src.stateCount;	
 		dst->tileRows		=	src.tileRows;	 
 		dst->tileCols		=	src.tileCols;	  
+		dst->tileStride		=	src.tileStride;	  
 		dst->clipTreshold	=	src.clipTreshold;
+		dst->kernel			=	src.kernel;
+		dst->threadCount	=	src.threadCount;
+		dst->temporalDepth	=	src.temporalDepth;
 
 		dst->maskRadx		=	src.maskRadx;	 
 		dst->maskRady		=	src.maskRady;	 
@@ -68,5 +135,17 @@ public:
 		dst->neigMask1d.resize(dst->maskElements);
 		
 		dst->neigMask1d=src.neigMask1d;
+		dst->maskTaps=src.maskTaps;
+		dst->weightTables=src.weightTables;
+		dst->boxLayers=src.boxLayers;
+		dst->fixedWeights=src.fixedWeights;
+		dst->fixedRow=src.fixedRow;
+		dst->jitRow=src.jitRow;
+		dst->bitTaps=src.bitTaps;
+		dst->bitBirth=src.bitBirth;
+		dst->bitSurvive=src.bitSurvive;
+
+		//kernels index scratch without capacity checks, so it's sized here and not while iterating
+		dst->boxScratch.resize(2*dst->tileCols+dst->maskHeight);
     }
 };
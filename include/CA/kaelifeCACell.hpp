@@ -0,0 +1,27 @@
+/**
+ * @file kaelifeCACell.hpp
+ *
+ * @brief CAData cell types and the rule types that grow with them
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief Types that depend on the cellState cell type
+ *
+ * uint8_t cells allow 256 states and adds within ±127. uint16_t cells allow 65536 states and adds within ±32767,
+ * but every cell is read and written as two bytes, so memory traffic doubles
+*/
+template<typename Cell>
+struct CACellTraits {
+	static_assert(std::is_same_v<Cell, uint8_t> || std::is_same_v<Cell, uint16_t>, "Cells are uint8_t or uint16_t");
+
+	typedef std::make_signed_t<Cell> Add; //ruleAdd
+	typedef std::conditional_t<sizeof(Cell)==1, int16_t, int32_t> Range; //ruleRange. Neighbor sum reaches maxCell per full weight tap
+	typedef std::conditional_t<sizeof(Cell)==1, uint16_t, uint32_t> Sum; //neighbor sum of one cell
+	static constexpr const uint maxCell = std::numeric_limits<Cell>::max();
+};
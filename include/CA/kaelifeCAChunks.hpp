@@ -0,0 +1,383 @@
+/**
+ * @file kaelifeCAChunks.hpp
+ *
+ * @brief CAData sparse iteration of unbounded worlds in fixed size chunks
+*/
+
+#pragma once
+
+#include "kaelRandom.hpp"
+#include "kaelifeCACache.hpp"
+#include "kaelifeCAGrid.hpp"
+#include "kaelifeCAKernel.hpp"
+#include "kaelifeCALock.hpp"
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+
+/**
+ * @brief Chunked world. World is an unbounded plane of chunkSize*chunkSize chunks kept in a hash map
+ *
+ * Only chunks with live cells and chunks that their live cells reach are allocated. A chunk is freed once it has been
+ * empty for two generations and no live cell reaches it, so memory follows the live area instead of the world size.
+ * Chunk is iterated by copying it and the mask reach of its 8 neighbors to a thread local padded grid and running
+ * a CAKernel row kernel on it. Chunks whose neighborhood didn't change are copied instead of iterated.
+ *
+ * cellState is a viewport of the plane, rows*cols cells centered at plane origin like CAHashlife.
+ * The plane doesn't wrap like cellState, cells leaving the viewport keep living outside it.
+ *
+ * Works for any mask up to chunkSize radius and rules that keep empty areas empty
+*/
+class CAChunks {
+public:
+	static constexpr const uint chunkShift = 6;
+	static constexpr const uint chunkSize = 1<<chunkShift; //cells per chunk side
+
+	CAChunks() {
+		reset();
+	}
+
+	/**
+	 * @brief Whether preset in cache can be iterated in chunks. Needs compiled ruleNext
+	*/
+	static bool fits(const CACache::ThreadCache &cache) {
+		if(cache.maskRadx>chunkSize || cache.maskRady>chunkSize){ return 0; } //only 8 neighbors are read
+		if(cache.ruleNext.empty() || cache.ruleOffset.empty()){ return 0; }
+		return cache.ruleNext[cache.ruleOffset[0]]==0; //unallocated chunks must stay empty
+	}
+
+	/**
+	 * @brief Copy mask and rules of a fitting preset and compile them for the chunk grid stride
+	 *
+	 * @param cache mainCache with loaded rules, maskTaps and weightTables
+	*/
+	void compileRules(const CACache::ThreadCache &cache) {
+		chunkCache = cache;
+		chunkCache.tileRows = chunkSize;
+		chunkCache.tileCols = chunkSize;
+		chunkCache.threadCount = 1;
+		reachX = cache.maskRadx;
+		reachY = cache.maskRady;
+
+		CAGrid<uint8_t> probe(chunkSize, chunkSize, std::max(reachX, reachY));
+		chunkCache.tileStride = probe.getStride();
+		uint tapInd = 0; //maskTaps are the non-zero neigMask1d elements in order
+		for(uint i=0;i<cache.maskElements;++i){
+			if(cache.neigMask1d[i]==0){continue;}
+			int x=i%cache.maskWidth-cache.maskRadx;
+			int y=i/cache.maskWidth-cache.maskRady;
+			chunkCache.maskTaps[tapInd++].offset = (int32_t)(x*(ptrdiff_t)chunkCache.tileStride+y);
+		}
+		CAKernel::compileBoxLayers(chunkCache);
+		chunkCache.kernel = CAKernel::resolveRowKernel(chunkCache);
+		chunkCache.boxScratch.resize(2*chunkSize+chunkCache.maskHeight);
+		workers.clear(); //rebuilt with the new stride
+	}
+
+	/**
+	 * @brief Empty plane and free every chunk
+	*/
+	void reset() {
+		chunks.clear();
+		active.clear();
+		readBuf = 0;
+		viewDirty = 1;
+	}
+
+	/**
+	 * @brief Replace viewport of the plane with grid before the next iterate. Not thread safe
+	*/
+	void markViewDirty() {
+		viewDirty = 1;
+	}
+
+	/**
+	 * @brief Advance the plane by generations and write the viewport to both grids
+	 *
+	 * Every iterating thread must call this with the same generations, chunks are shared with an atomic counter.
+	 * Thread 0 allocates and frees chunks between generations
+	 *
+	 * @param grids cellState
+	 * @param lv thread cache. lv.activeBuf grid is imported if the viewport was changed
+	 * @param localBarrier barrier of every thread iterating the world
+	 * @param generations generations to iterate
+	 * @return cells iterated by this thread
+	*/
+	size_t iterate(CAGrid<uint8_t> (&grids)[2], const CACache::ThreadCache &lv, CABarrier &localBarrier, const size_t generations) {
+		if(lv.threadId==0 && viewDirty){
+			importView(grids[lv.activeBuf]);
+			viewDirty = 0;
+		}
+
+		size_t cells = 0;
+		for(size_t i=0;i<generations;i++){
+			if(lv.threadId==0){
+				prepareGeneration(lv.threadCount);
+			}
+			localBarrier.arrive_and_wait();
+
+			CACache::ThreadCache &wc = workers[lv.threadId];
+			size_t ind;
+			while((ind = nextChunk.fetch_add(1, std::memory_order_relaxed)) < active.size()){
+				cells += stepChunk(wc, *active[ind]) ? chunkSize*chunkSize : 0;
+			}
+			localBarrier.arrive_and_wait();
+
+			if(lv.threadId==0){
+				readBuf = !readBuf;
+			}
+		}
+
+		if(lv.threadId==0){
+			exportView(grids);
+		}
+		return cells;
+	}
+
+	/** @brief Allocated chunks */
+	size_t chunkCount() const { return chunks.size(); }
+	/** @brief Bytes of allocated chunk cells */
+	size_t chunkBytes() const { return chunks.size()*sizeof(Chunk); }
+
+private:
+	/**
+	 * @brief Double buffered chunkSize*chunkSize cells. cells[readBuf] is the current generation
+	*/
+	struct Chunk {
+		alignas(64) uint8_t cells[2][chunkSize*chunkSize] = {};
+		Chunk* near[9] = {}; //3*3 neighborhood, this in the center. nullptr is an empty chunk
+		int32_t cx = 0;
+		int32_t cy = 0;
+		bool changed[2] = {}; //cells[b] differ from the generation before
+		bool live = 0; //cells[readBuf] has a non-zero cell
+		bool needed = 0; //kept by prepareGeneration
+		uint8_t minX = 0, maxX = 0, minY = 0, maxY = 0; //live cells bounding box
+	};
+
+	struct ChunkHash {
+		size_t operator()(const uint64_t key) const {
+			return kaelife::rand(key);
+		}
+	};
+
+	std::unordered_map<uint64_t, std::unique_ptr<Chunk>, ChunkHash> chunks;
+	std::vector<Chunk*> active; //chunks iterated this generation
+	alignas(64) std::atomic<size_t> nextChunk = 0;
+	bool readBuf = 0;
+	bool viewDirty = 1;
+
+	CACache::ThreadCache chunkCache; //mainCache compiled for chunk grid stride
+	std::vector<CACache::ThreadCache> workers; //chunkCache copy of each thread, with its own scratch
+	uint reachX = 0;
+	uint reachY = 0;
+
+	static inline uint64_t chunkKey(const int32_t cx, const int32_t cy) {
+		return (uint64_t)(uint32_t)cx<<32 | (uint32_t)cy;
+	}
+
+	Chunk* findChunk(const int32_t cx, const int32_t cy) const {
+		auto it = chunks.find(chunkKey(cx, cy));
+		return it==chunks.end() ? nullptr : it->second.get();
+	}
+
+	/**
+	 * @brief Existing or new empty chunk
+	*/
+	Chunk* getChunk(const int32_t cx, const int32_t cy) {
+		std::unique_ptr<Chunk> &chunk = chunks[chunkKey(cx, cy)];
+		if(!chunk){
+			chunk = std::make_unique<Chunk>();
+			chunk->cx = cx;
+			chunk->cy = cy;
+		}
+		return chunk.get();
+	}
+
+	/**
+	 * @brief Set live and bounding box of cells[buf]
+	*/
+	static void measureChunk(Chunk &chunk, const bool buf) {
+		chunk.live = 0;
+		for(uint x=0;x<chunkSize;x++){
+			const uint8_t* row = chunk.cells[buf] + x*chunkSize;
+			uint y0 = 0;
+			while(y0<chunkSize && row[y0]==0){ y0++; }
+			if(y0==chunkSize){ continue; }
+			uint y1 = chunkSize-1;
+			while(row[y1]==0){ y1--; }
+			if(!chunk.live){
+				chunk.live = 1;
+				chunk.minX = x;
+				chunk.minY = y0;
+				chunk.maxY = y1;
+			}
+			chunk.maxX = x;
+			chunk.minY = std::min<uint>(chunk.minY, y0);
+			chunk.maxY = std::max<uint>(chunk.maxY, y1);
+		}
+	}
+
+	/**
+	 * @brief Allocate chunks that live cells reach, free the rest and list them for threads. Thread 0 only
+	*/
+	void prepareGeneration(const uint threadCount) {
+		std::vector<Chunk*> liveChunks;
+		for(auto &entry : chunks){
+			Chunk &chunk = *entry.second;
+			chunk.needed = chunk.live || chunk.changed[readBuf]; //empty neighbor must stay unchanged when freed
+			if(chunk.live){
+				liveChunks.push_back(&chunk);
+			}
+		}
+		for(Chunk* chunk : liveChunks){ //getChunk may rehash, so neighbors are added after the loop
+			for(int dx=-1;dx<=1;dx++){
+				if(dx<0 && chunk->minX>=reachX){ continue; }
+				if(dx>0 && chunk->maxX+reachX<chunkSize){ continue; }
+				for(int dy=-1;dy<=1;dy++){
+					if(dy<0 && chunk->minY>=reachY){ continue; }
+					if(dy>0 && chunk->maxY+reachY<chunkSize){ continue; }
+					getChunk(chunk->cx+dx, chunk->cy+dy)->needed = 1;
+				}
+			}
+		}
+		std::erase_if(chunks, [](const auto &entry){ return !entry.second->needed; });
+
+		active.clear();
+		for(auto &entry : chunks){
+			Chunk &chunk = *entry.second;
+			for(uint i=0;i<9;i++){
+				chunk.near[i] = findChunk(chunk.cx+(int)(i/3)-1, chunk.cy+(int)(i%3)-1);
+			}
+			active.push_back(&chunk);
+		}
+		nextChunk.store(0, std::memory_order_relaxed);
+
+		if(workers.size()<threadCount){
+			workers.resize(threadCount, chunkCache);
+			for(CACache::ThreadCache &wc : workers){
+				const size_t halo = std::max(reachX, reachY);
+				for(int j=0;j<2;j++){
+					if(wc.tileScratch[j].getRows()!=chunkSize){ wc.tileScratch[j].resize(chunkSize, chunkSize, halo); }
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Copy rows [x0,x1) and columns [y0,y1) of src chunk to scratch at dstX,dstY. Zero if src is empty
+	*/
+	static void gather(CAGrid<uint8_t> &scratch, const Chunk* src, const bool buf, const int dstX, const int dstY, const uint x0, const uint x1, const uint y0, const uint y1) {
+		for(uint x=x0;x<x1;x++){
+			uint8_t* dst = scratch[dstX+(int)(x-x0)] + dstY;
+			if(src){
+				std::memcpy(dst, src->cells[buf] + x*chunkSize + y0, y1-y0);
+			}else{
+				std::memset(dst, 0, y1-y0);
+			}
+		}
+	}
+
+	/**
+	 * @brief Write next generation of chunk to cells[!readBuf]
+	 *
+	 * @return false if the chunk was copied instead of iterated
+	*/
+	bool stepChunk(CACache::ThreadCache &wc, Chunk &chunk) {
+		bool nearChanged = 0;
+		for(const Chunk* n : chunk.near){
+			nearChanged |= n && n->changed[readBuf];
+		}
+		if(!nearChanged){ //same neighborhood as last generation gives the same cells
+			std::memcpy(chunk.cells[!readBuf], chunk.cells[readBuf], chunkSize*chunkSize);
+			chunk.changed[!readBuf] = 0;
+			return 0;
+		}
+
+		CAGrid<uint8_t> &scratch = wc.tileScratch[0];
+		const uint rx = reachX;
+		const uint ry = reachY;
+		const uint xFrom[3] = {chunkSize-rx, 0, 0};
+		const uint xTo[3]   = {chunkSize, chunkSize, rx};
+		const int  xDst[3]  = {-(int)rx, 0, chunkSize};
+		const uint yFrom[3] = {chunkSize-ry, 0, 0};
+		const uint yTo[3]   = {chunkSize, chunkSize, ry};
+		const int  yDst[3]  = {-(int)ry, 0, chunkSize};
+		for(uint i=0;i<9;i++){
+			gather(scratch, chunk.near[i], readBuf, xDst[i/3], yDst[i%3], xFrom[i/3], xTo[i/3], yFrom[i%3], yTo[i%3]);
+		}
+
+		CAGrid<uint8_t> &next = wc.tileScratch[1];
+		bool changed = 0;
+		for(uint x=0;x<chunkSize;x++){
+			changed |= CAKernel::iterateRow(wc, scratch.data(), next.data(), x, 0, chunkSize);
+			std::memcpy(chunk.cells[!readBuf] + x*chunkSize, next[x], chunkSize);
+		}
+		chunk.changed[!readBuf] = changed;
+		if(changed){
+			measureChunk(chunk, !readBuf);
+		}
+		return 1;
+	}
+
+	/**
+	 * @brief Viewport origin in plane coordinates
+	*/
+	inline int64_t viewX(const CAGrid<uint8_t> &grid) const { return -(int64_t)grid.getRows()/2; }
+	inline int64_t viewY(const CAGrid<uint8_t> &grid) const { return -(int64_t)grid.getCols()/2; }
+
+	/**
+	 * @brief Replace viewport area of the plane with grid
+	*/
+	void importView(const CAGrid<uint8_t> &grid) {
+		const int64_t vx = viewX(grid);
+		const int64_t vy = viewY(grid);
+		const int64_t rows = grid.getRows();
+		const int64_t cols = grid.getCols();
+		for(int64_t cx=vx>>chunkShift; cx<=(vx+rows-1)>>chunkShift; cx++){
+			for(int64_t cy=vy>>chunkShift; cy<=(vy+cols-1)>>chunkShift; cy++){
+				Chunk* chunk = getChunk(cx, cy);
+				const int64_t x0 = std::max(cx<<chunkShift, vx);
+				const int64_t x1 = std::min((cx+1)<<chunkShift, vx+rows);
+				const int64_t y0 = std::max(cy<<chunkShift, vy);
+				const int64_t y1 = std::min((cy+1)<<chunkShift, vy+cols);
+				for(int64_t x=x0;x<x1;x++){
+					std::memcpy(chunk->cells[readBuf] + (x-(cx<<chunkShift))*chunkSize + (y0-(cy<<chunkShift)), grid[x-vx]+(y0-vy), y1-y0);
+				}
+				chunk->changed[0] = chunk->changed[1] = 1;
+				measureChunk(*chunk, readBuf);
+			}
+		}
+	}
+
+	/**
+	 * @brief Write viewport of the plane to both grids and refresh their halo
+	*/
+	void exportView(CAGrid<uint8_t> (&grids)[2]) {
+		grids[0].clear();
+		const int64_t vx = viewX(grids[0]);
+		const int64_t vy = viewY(grids[0]);
+		const int64_t rows = grids[0].getRows();
+		const int64_t cols = grids[0].getCols();
+		for(auto &entry : chunks){
+			const Chunk &chunk = *entry.second;
+			if(!chunk.live){ continue; } //grid is cleared
+			const int64_t x0 = std::max((int64_t)chunk.cx<<chunkShift, vx);
+			const int64_t x1 = std::min(((int64_t)chunk.cx+1)<<chunkShift, vx+rows);
+			const int64_t y0 = std::max((int64_t)chunk.cy<<chunkShift, vy);
+			const int64_t y1 = std::min(((int64_t)chunk.cy+1)<<chunkShift, vy+cols);
+			for(int64_t x=x0;x<x1 && y0<y1;x++){
+				std::memcpy(grids[0][x-vx]+(y0-vy), chunk.cells[readBuf] + (x-((int64_t)chunk.cx<<chunkShift))*chunkSize + (y0-((int64_t)chunk.cy<<chunkShift)), y1-y0);
+			}
+		}
+		for(size_t x=0;x<grids[0].getRows();x++){
+			std::memcpy(grids[1][x], grids[0][x], grids[0].getCols());
+			grids[0].refreshRowHalo(x);
+			grids[1].refreshRowHalo(x);
+		}
+	}
+};
@@ -9,22 +9,30 @@
  * 1. startWorkerThreads starts the worker threads and joins then upon exit. Each thread cache is initialized with default mainCache.
  * 2. Each thread runs a loop in iterateWorld and has a unique stripe of cellState so (ideally) no data race is possible
  * 3. Each thread waits for CAData.CALock.continueThread([TASK SIZE],[ACTIVE BUFFER]) command and iterates number of [TASK SIZE] times. 
- * 4. When all threads are done, they wait for next "continueThread" call, or until "terminateThread" is called
+ * 4. When all threads are done, they wait for next "continueThread" call, or until "terminateThread" is called. syncMainThread takes the buffer of their last generation
  * 
  * Main thread and classes like InputHandler may add not-thread-safe tasks to backlog
  * Main thread may call backlog.doBacklog() which executes queued tasks
+ * In pipelined mode the thread that dispatches tasks is not the render thread, it publishes finished tasks to frames
  * 
 */
 
 #pragma once
 
-#include "kaelife.hpp"
 #include "kaelRandom.hpp"
 #include "kaelifeCALock.hpp"
 #include "kaelifeWorldMatrix.hpp"
 #include "kaelifeCAPreset.hpp"
 #include "kaelifeCACache.hpp"
 #include "kaelifeCADraw.hpp"
+#include "kaelifeCAGrid.hpp"
+#include "kaelifeCAKernel.hpp"
+#include "kaelifeCABitEngine.hpp"
+#include "kaelifeCAHashlife.hpp"
+#include "kaelifeCAChunks.hpp"
+#include "kaelifeCAJit.hpp"
+#include "kaelifeCANuma.hpp"
+#include "kaelifeCAFrame.hpp"
 
 #include <iostream>
 #include <cmath>
@@ -36,48 +44,161 @@
 #include <string.h>
 #include <array>
 #include <memory>
-#include <barrier>
 #include <syncstream>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <chrono>
 
-class CABacklog; // Forward declaration
+#if defined(__linux__)
+	#include <unistd.h>
+#endif
+
+template<typename Cell> class CABacklogT; // Forward declaration
 
 /**
  * @brief Cellular Automata Data. Manages and iterates cellState that holds CA cell states
  * 
+ * @tparam Cell cellState cell type. uint8_t for up to 256 states, uint16_t for up to 65536 states with scalar and box kernels
  */
-class CAData {
+template<typename Cell>
+class CADataT {
 public:
+	/** @brief Thread cache of this cell type*/
+	typedef CACache::ThreadCacheT<Cell> ThreadCache;
 	
 	/** @brief Thread locking*/
 	CALock kaeMutex; 
 	/** @brief Automata configurations*/
-	CAPreset kaePreset; 
+	CAPresetT<Cell> kaePreset; 
 	/** @brief Unique thread chaches*/
 	CACache kaeCache; 
 	/** @brief cache of CAData that should be used to update thread cache synchronously*/
-	CACache::ThreadCache mainCache; 
+	ThreadCache mainCache; 
 	/** @brief InputHandler drawn pixels*/
 	CADraw kaeDraw; 
 	/** @brief Not thread safe task queue*/
-    std::unique_ptr<CABacklog> backlog; 
+    std::unique_ptr<CABacklogT<Cell>> backlog; 
 
-	CAData();
+	/**
+	 * @param rows world X dimension. Halved with cols until the world fits maxWorldBytes
+	 * @param cols world Y dimension
+	 * @param maxBytes largest cellState buffer, 0 uses defaultMaxWorldBytes
+	*/
+	CADataT(uint rows=defaultRows, uint cols=defaultCols, uint64_t maxBytes=0);
 
 public: //public vars and custom data types
 
-	//Doxygen doesn't understand __aligned__
     /**
      * @brief Holds 2D cellular automata states. Double buffered.
 	 * 
-     * Writes must be done to [Active Buffer] !mainCache.activeBuf,
-     * and reads must be done from mainCache.activeBuf. X is left to right.
+     * Threads read activeBuf, write every iterated cell to !activeBuf and swap. Main thread writes are done to 
+     * mainCache.activeBuf followed by cloneBuffer, and reads must be done from mainCache.activeBuf. X is left to right.
      * Y is down to up (Row major). cellState[Active Buffer][X][Y]
      *
+	 * Each buffer is a single 64-byte aligned allocation, see CAGrid
+	 * The world is surrounded by halo cells that mirror the opposite border so iteration never wraps coordinates
      */
-    __attribute__((__aligned__(64))) std::vector<std::vector<uint8_t>> cellState[2];
+    CAGrid<Cell> cellState[2];
+
+	/** @brief Packed world of KERNEL_BIT */
+	CABitEngine bitEngine;
+
+	/** @brief Unbounded plane of KERNEL_HASHLIFE. cellState is its viewport */
+	CAHashlife hashlife;
+
+	/** @brief Unbounded plane of KERNEL_CHUNKED. cellState is its viewport */
+	CAChunks chunks;
+
+	/** @brief Runtime compiled presets of KERNEL_JIT */
+	CAJit jit;
+
+	/** @brief Worlds published by publishFrame. Renderer reads these instead of cellState in pipelined mode */
+	CAFrameBufferT<Cell> frames;
+
+	/** @brief Generations iterated since start. Written by the thread that dispatches tasks */
+	std::atomic<uint64_t> generation = 0;
+
+	/** @brief Node topology used by numaPlacement */
+	CANuma numa;
+
+	/**
+	 * @brief Pin worker threads to cores and let each thread first touch its stripe of cellState. Change with setNumaPlacement
+	 * 
+	 * Enabled by default if the machine has more than one NUMA node
+	*/
+	bool numaPlacement = 0;
+
+	/** @brief Worker threads started by startWorkerThreads. mainCache.threadCount of them iterate */
+	uint poolSize = 1;
+
+	/** @brief Barrier of iterating threads. Count follows mainCache.threadCount */
+	CABarrier iterBarrier{1};
+
+	/** @brief Untouched copy of one cellState buffer that pool threads first touch in placeThread. Empty outside placeThread */
+	CAGrid<Cell> placed;
+	/** @brief Set while numaPlacement is on and cellState or stripes moved. Pool threads place cellState before their next task */
+	bool placePending = 0;
+	/** @brief Barrier of every pool thread in placeThread */
+	CABarrier placeBarrier{1};
+
+	/** @brief activeBuf after the last iteration task. Written by thread 0, read by syncMainThread */
+	std::atomic<bool> resultBuf = 0;
+
+	/** @brief User selected iteration kernel. Resolved to mainCache.kernel in loadPreset */
+	CAKernel::KernelType kernelPreference = CAKernel::KERNEL_AUTO;
+
+	/**
+	 * @brief Dirty block flags. blockChanged[buf][bx][by] is set if any cell of the block changed in the last iteration
+	 *
+	 * Blocks are blockRows*blockCols cells. A block is skipped if no block within mask reach changed.
+	 * Every block row starts a cache line, so threads iterating neighboring block rows don't write the same line
+	*/
+	CAGrid<uint8_t> blockChanged[2];
+	/** @brief blockChanged buffer that the next iteration reads. Written only by thread 0 at task end */
+	bool blockFlagBuf = 0;
+	static constexpr const uint blockRows = 8; //also the work stealing unit, one block row
+	static constexpr const uint temporalTileRows = 32; //rows of one temporal blocking tile, overlap rows excluded
+	static constexpr const uint temporalMaxDepth = 8; //deepest temporalDepth selected by nextTemporalDepth
+
+	static constexpr const uint blockCols = 64;
+	uint blocksX = 0;
+	uint blocksY = 0;
+
+	/**
+	 * @brief Block rows left for one thread in the current iteration. Owner pops the front, other threads steal the back
+	 *
+	 * First block row is in low 32 bits and the row past the end in high 32 bits, so both ends change in one CAS
+	*/
+	struct alignas(64) StealRange {
+		std::atomic<uint64_t> range = 0;
+	};
+	std::vector<StealRange> stealRanges;
+
+	/**
+	 * @brief Iteration time of one thread. Written only by the owner, read and reset by printThreadTiming
+	*/
+	struct alignas(64) ThreadTiming {
+		std::atomic<uint64_t> workNs = 0; //iterating and cloning
+		std::atomic<uint64_t> waitNs = 0; //waiting other threads in localBarrier
+		std::atomic<uint64_t> stolen = 0; //block rows taken from other threads
+		std::atomic<uint64_t> cells = 0; //cells written
+		uint node = 0; //NUMA node the thread is pinned to
+	};
+	std::vector<ThreadTiming> threadTiming;
+
+	/** @brief Default cellState halo. randRuleMask masks are at most 8x8 */
+	static constexpr const uint defaultHalo = 4;
+	/** @brief Default world dimensions */
+	static constexpr const uint defaultRows = 576;
+	static constexpr const uint defaultCols = 384;
+	/** @brief Largest initial window side. Bigger worlds are scaled down to fit */
+	static constexpr const uint maxRenderSize = 2048;
+	/** @brief Largest cellState buffer the constructor and resizeWorld allocate. Two buffers and published frames are allocated at this size */
+	uint64_t maxWorldBytes = 0;
+	/** @brief maxWorldBytes if physical memory is unknown */
+	static constexpr const uint64_t fallbackWorldBytes = 256ull<<20;
 
 
 	//BOF vars that only CAData writes but others may read
@@ -108,6 +229,14 @@ public: //public functions
 		mainCache.maskRady		=	(mainCache.maskHeight)/2;
 		mainCache.clipTreshold	=	kaePreset.current()->clipTreshold;
 
+		//grow halo if the new mask reaches further than the current halo
+		uint needHalo = std::max(mainCache.maskRadx, mainCache.maskRady);
+		if(needHalo > cellState[0].getHalo()){
+			for(int j=0;j<2;j++){
+				cellState[j].setHalo(needHalo);
+			}
+		}
+
 		mainCache.neigMask1d.clear();
 		if(mainCache.maskElements!=0){
 			mainCache.neigMask1d.resize( mainCache.maskElements );
@@ -120,41 +249,268 @@ public: //public functions
 			}
 		}
 
+		//compile mask to cellState offsets so iteration only visits non-zero elements
+		mainCache.tileStride = cellState[0].getStride();
+		mainCache.maskTaps.clear();
+		for(int i=0;i<mainCache.maskElements;++i){
+			if(mainCache.neigMask1d[i]==0){continue;}
+			int x=i%mainCache.maskWidth-mainCache.maskRadx; //coordinate relative to mask center
+			int y=i/mainCache.maskWidth-mainCache.maskRady;
+			CACache::MaskTap tap = {
+				.offset = (int32_t)(x*(ptrdiff_t)mainCache.tileStride+y),
+				.weight = mainCache.neigMask1d[i],
+				.table	= 0
+			};
+			mainCache.maskTaps.push_back(tap);
+		}
+
+		CAKernel::compileBoxLayers(mainCache);
+		CAKernel::compileRules(mainCache);
+		if constexpr(sizeof(Cell)==1){ //weight tables, fixed instances, packed rules and generated code read 8-bit cells
+			CAKernel::compileWeights(mainCache);
+			CAKernel::compileFixed(mainCache);
+			CABitEngine::compileRules(mainCache);
+			mainCache.jitRow = kernelPreference==CAKernel::KERNEL_JIT ? jit.compile(mainCache) : nullptr; //only compile when asked, it blocks for a while
+		}
+		mainCache.kernel = CAKernel::resolveKernel(kernelPreference, mainCache);
+		if constexpr(sizeof(Cell)==1){
+			if(mainCache.kernel==CAKernel::KERNEL_CHUNKED && !CAChunks::fits(mainCache)){
+				mainCache.kernel = CAKernel::resolveKernel(CAKernel::KERNEL_AUTO, mainCache);
+			}
+			if(mainCache.kernel==CAKernel::KERNEL_BIT){
+				bitEngine.resize(mainCache.tileRows, mainCache.tileCols);
+			}
+			if(mainCache.kernel==CAKernel::KERNEL_HASHLIFE){
+				hashlife.reset(); //plane outside viewport lived by other rules, restart from cellState
+				hashlife.compileRules(mainCache);
+			}
+			if(mainCache.kernel==CAKernel::KERNEL_CHUNKED){
+				chunks.reset(); //restart from cellState like hashlife
+				chunks.compileRules(mainCache);
+			}
+		}
+		markAllBlocks(); //new rules may change any cell
+
 		mainCache.index++;
 	}
 
 	/**
-	 * @brief Multithreaded cloneBuffer
+	 * @brief Change world dimensions and keep the cells that fit. Not thread safe
 	 * 
-	 * @param lv unique thread cache
+	 * Buffers are reallocated one at a time, so at most one old and one new world are allocated at once.
+	 * Threads pick up the new dimensions with mainCache.index like any preset change
 	 * 
-	 * Each thread clones stripes of cellState to activeBuf and local thread activeBuf is swapped
+	 * @param rows new world X dimension
+	 * @param cols new world Y dimension
+	 * @param recenter keep the old world centered, else keep cell 0,0 in place
+	 * @return false if the world would exceed maxWorldBytes and was kept as is
 	*/
-	inline void threadCloneBuffer(CACache::ThreadCache &lv) {
+	bool resizeWorld(uint rows, uint cols, bool recenter=true){
+		rows = std::max(rows, 1u);
+		cols = std::max(cols, 1u);
+		const uint oldRows = mainCache.tileRows;
+		const uint oldCols = mainCache.tileCols;
+		if(rows==oldRows && cols==oldCols){ return true; }
+		if(!worldFits(rows, cols)){
+			printf("World %ux%u exceeds %lu MiB, kept %ux%u\n", rows, cols, maxWorldBytes>>20, oldRows, oldCols);
+			return false;
+		}
 
-		//clone buffer for updated cells only
-		for (size_t i = 0; i < lv.updatedCells[0].size(); ++i) {
-			uint16_t x = lv.updatedCells[0][i];
-			uint16_t y = lv.updatedCells[1][i];
-			cellState[lv.activeBuf][x][y] = cellState[!lv.activeBuf][x][y];
+		const bool oldBuf = mainCache.activeBuf;
+		const bool newBuf = !oldBuf; //inactive buffer is rewritten every generation, so it's free to reallocate first
+		const size_t halo = cellState[oldBuf].getHalo();
+		cellState[newBuf].resize(rows, cols, halo);
+
+		const int64_t offsetX = recenter ? ((int64_t)rows-oldRows)/2 : 0;
+		const int64_t offsetY = recenter ? ((int64_t)cols-oldCols)/2 : 0;
+		const int64_t y0 = std::max<int64_t>(offsetY, 0); //first new column with an old cell
+		const int64_t y1 = std::min<int64_t>(offsetY+oldCols, cols);
+		for(int64_t x=std::max<int64_t>(offsetX, 0); x<std::min<int64_t>(offsetX+oldRows, rows); x++){
+			if(y0>=y1){ break; }
+			std::memcpy(cellState[newBuf][x]+y0, cellState[oldBuf][x-offsetX]+(y0-offsetY), (y1-y0)*sizeof(Cell));
 		}
+		cellState[oldBuf].resize(rows, cols, halo);
 
-		lv.updatedCells[0].clear();
-		lv.updatedCells[1].clear();
+		mainCache.activeBuf = newBuf;
+		resultBuf.store(newBuf); //syncMainThread without a task keeps the new buffer
+		mainCache.tileRows = rows;
+		mainCache.tileCols = cols;
+		aspectRatio = (float)rows/cols;
 
-		//swap buffer index
-		lv.activeBuf = !lv.activeBuf;
+		resizeBlocks();
+		loadPreset(); //tap offsets depend on row stride, kernels resize their worlds, stripes are recomputed
+		cloneBuffer();
+		requestPlacement(); //new grids were first touched by this thread
+		return true;
 	}
 
 	/**
-	 * @brief Single threaded clone buffer
+	 * @brief Whether a rows*cols world fits maxWorldBytes
+	*/
+	bool worldFits(uint rows, uint cols) const {
+		return (uint64_t)rows*cols*sizeof(Cell) <= maxWorldBytes;
+	}
+
+	/**
+	 * @brief Default maxWorldBytes, an eighth of physical memory
+	 * 
+	 * Two cellState buffers, three published frames and one buffer being placed by placeThread may exist at once
+	*/
+	static uint64_t defaultMaxWorldBytes(){
+		#if defined(__linux__)
+			const long pages = sysconf(_SC_PHYS_PAGES);
+			const long pageSize = sysconf(_SC_PAGE_SIZE);
+			if(pages>0 && pageSize>0){
+				return (uint64_t)pages*pageSize/8;
+			}
+		#endif
+		return fallbackWorldBytes;
+	}
+
+	/**
+	 * @brief Let pool threads first touch cellState again before their next task, so each stripe sits on the node that iterates it. Not thread safe
+	*/
+	void requestPlacement(){
+		if(!numaPlacement){ return; }
+		placePending = 1; //placed is allocated in placeThread, one buffer at a time
+	}
+
+	/**
+	 * @brief Allocate blockChanged for current world dimensions and mark every block. Not thread safe
+	*/
+	void resizeBlocks(){
+		blocksX = (mainCache.tileRows+blockRows-1)/blockRows;
+		blocksY = (mainCache.tileCols+blockCols-1)/blockCols;
+		for(int j=0;j<2;j++){
+			blockChanged[j].resize(blocksX, blocksY);
+			blockChanged[j].fillRows(0, blocksX, 1);
+		}
+	}
+
+	/**
+	 * @brief Iterate every block in the next iteration. Call after any cellState write outside iteration
+	*/
+	void markAllBlocks(){
+		for(int j=0;j<2;j++){
+			blockChanged[j].fillRows(0, blocksX, 1);
+		}
+		hashlife.markViewDirty();
+		chunks.markViewDirty();
+	}
+
+	/**
+	 * @brief Whether any block within reach of block bx,by changed. Wraps like the world
+	*/
+	inline bool blockNeighborChanged(const CAGrid<uint8_t> &changed, const uint bx, const uint by, const uint reachX, const uint reachY) const {
+		for(uint i=0;i<=2*reachX;i++){
+			const uint nx = (bx+blocksX*reachX+i-reachX)%blocksX;
+			const uint8_t* changedRow = changed[nx];
+			for(uint j=0;j<=2*reachY;j++){
+				if(changedRow[(by+blocksY*reachY+j-reachY)%blocksY]){ return 1; }
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Allocate per thread scheduler slots. Not thread safe
+	*/
+	void resizeThreadSlots(const uint threadCount){
+		stealRanges = std::vector<StealRange>(threadCount);
+		threadTiming = std::vector<ThreadTiming>(threadCount);
+	}
+
+	/**
+	 * @brief Take one block row from stealRanges[owner]. Temporal blocking takes tiles the same way
+	 * 
+	 * @param owner thread whose range is used
+	 * @param steal take from the back, else from the front
+	 * @param bx taken block row
+	 * @return false if the range is empty
+	*/
+	inline bool takeBlockRow(const uint owner, const bool steal, uint &bx){
+		std::atomic<uint64_t> &range = stealRanges[owner].range;
+		uint64_t current = range.load(std::memory_order_acquire);
+		while(1){
+			const uint32_t front = current;
+			const uint32_t back = current>>32;
+			if(front>=back){ return 0; }
+			const uint64_t next = steal ? (uint64_t)(back-1)<<32 | front : (uint64_t)back<<32 | (front+1);
+			if(range.compare_exchange_weak(current, next, std::memory_order_acq_rel)){
+				bx = steal ? back-1 : front;
+				return 1;
+			}
+		}
+	}
+
+	/**
+	 * @brief Print and reset threadTiming of iterating threads
+	 * 
+	 * With numaPlacement, also prints per node cell rate and the cell traffic it implies
+	*/
+	void printThreadTiming(){
+		std::vector<double> nodeWorkMs(numa.nodeCount(), 0.0);
+		std::vector<uint64_t> nodeCells(numa.nodeCount(), 0);
+		std::vector<uint> nodeThreads(numa.nodeCount(), 0);
+		for(size_t i=0;i<std::min<size_t>(mainCache.threadCount, threadTiming.size());i++){
+			const double workMs = threadTiming[i].workNs.exchange(0)/1e6;
+			const double waitMs = threadTiming[i].waitNs.exchange(0)/1e6;
+			const uint64_t stolen = threadTiming[i].stolen.exchange(0);
+			const uint64_t cells = threadTiming[i].cells.exchange(0);
+			const double waitShare = workMs+waitMs>0 ? 100.0*waitMs/(workMs+waitMs) : 0.0;
+			const double cellRate = workMs>0 ? cells/workMs/1000.0 : 0.0;
+			printf("  thread %zu work %.1f ms wait %.1f ms (%.0f%%) stolen %lu %.0f Mcell/s\n", i, workMs, waitMs, waitShare, stolen, cellRate);
+			const uint node = threadTiming[i].node;
+			nodeWorkMs[node] += workMs;
+			nodeCells[node] += cells;
+			nodeThreads[node]++;
+		}
+		if(!numaPlacement){ return; }
+		//threads of a node run in parallel, so node time is the mean thread time.
+		//Memory traffic is not measured. Cell traffic is one read and one write of each iterated cell, not the bytes DRAM moved
+		for(uint node=0;node<numa.nodeCount();node++){
+			if(nodeThreads[node]==0 || nodeWorkMs[node]<=0){ continue; }
+			const double nodeMs = nodeWorkMs[node]/nodeThreads[node];
+			printf("  node %u: %u threads %.0f Mcell/s ~%.2f GB/s estimated cell traffic\n", node, nodeThreads[node], 
+				nodeCells[node]/nodeMs/1000.0, 2.0*sizeof(Cell)*nodeCells[node]/nodeMs/1e6);
+		}
+	}
+
+	/**
+	 * @brief Publish main thread writes to cellState[mainCache.activeBuf]. Not thread safe
+	 * 
+	 * Buffers are not copied. Every block is marked changed, so the next iteration writes the whole 
+	 * !activeBuf from activeBuf and the older generation in !activeBuf is never read
 	*/
 	void cloneBuffer(){
-		//clone buffer
-		cellState[mainCache.activeBuf] = cellState[!mainCache.activeBuf];
+		//backlog tasks write world cells only
+		cellState[mainCache.activeBuf].refreshHalo();
+		markAllBlocks();
+	}
 
-		//swap buffer index
-		mainCache.activeBuf = !mainCache.activeBuf;
+	/**
+	 * @brief Wait until threads are at waitResume and take the buffer of their last generation. Main thread only
+	*/
+	void syncMainThread(){
+		kaeMutex.syncMainThread();
+		mainCache.activeBuf = resultBuf.load();
+	}
+
+	/**
+	 * @brief Copy cellState[mainCache.activeBuf] to frames. Threads must be at waitResume, main thread only
+	*/
+	void publishFrame(){
+		typename CAFrameBufferT<Cell>::Frame &frame = frames.back();
+		if(frame.cells.getRows()!=mainCache.tileRows || frame.cells.getCols()!=mainCache.tileCols){
+			frame.cells.resize(mainCache.tileRows, mainCache.tileCols); //back frame is not read, reader sees new dimensions with the frame
+		}
+		const CAGrid<Cell> &grid = cellState[mainCache.activeBuf];
+		for(size_t x=0;x<mainCache.tileRows;x++){
+			std::memcpy(frame.cells[x], grid[x], mainCache.tileCols*sizeof(Cell));
+		}
+		frame.stateCount = mainCache.stateCount;
+		frame.generation = generation.load(std::memory_order_relaxed);
+		frames.publish();
 	}
 
 
@@ -162,22 +518,28 @@ public: //public functions
 	//BOF iterate functions
 	public:
 		/**
-		 * @brief Start worker threads and wait them to join
+		 * @brief Start poolSize worker threads and wait them to join
 		 * 
-		 * Each creates a unique copy of mainCache 
+		 * Each creates a unique copy of mainCache. Only first mainCache.threadCount threads iterate, see setThreadCount
 		*/
 		inline void startWorkerThreads(std::vector<std::thread> &threads) {
 
-			kaeMutex.expectedThreadCount(mainCache.threadCount);
-			std::barrier localBarrier(mainCache.threadCount);
-			CACache::ThreadCache cache = mainCache;
+			poolSize = std::max(poolSize, mainCache.threadCount);
+			kaeMutex.expectedThreadCount(poolSize);
+			resizeThreadSlots(poolSize);
+			iterBarrier.setCount(mainCache.threadCount);
+			ThreadCache cache = mainCache;
 			kaeCache.copyCache(&cache, mainCache);
 
-			for (uint i = 0; i < mainCache.threadCount; ++i) {
+			//pinned threads first touch their stripes of cellState before they first wait
+			placeBarrier.setCount(poolSize);
+			requestPlacement();
+
+			for (uint i = 0; i < poolSize; ++i) {
 				cache.threadId=i;
 
 				threads.emplace_back([&, cache]() {
-					iterateWorld(cache, localBarrier);
+					iterateWorld(cache, iterBarrier);
 				});
 			}
 			for (auto &thread : threads){
@@ -197,171 +559,522 @@ public: //public functions
 		 * @param lv Unique thread cache
 		 * @param localBarrier barrier to synchronize critical parts 
 		*/
-		inline void iterateWorld(CACache::ThreadCache lv, std::barrier<>& localBarrier) {
+		inline void iterateWorld(ThreadCache lv, CABarrier& localBarrier) {
 			uint localIterTask=0;
-
-			//spread threads task to 2D stripes 
-			uint iterSize	=(lv.tileRows+lv.threadCount/2)/lv.threadCount;
-			uint remainder	= lv.tileRows%lv.threadCount; //remaining rows that couldn't be split evenly
-			uint iterStart	= lv.threadId*iterSize;
-			uint iterEnd	=(lv.threadId+1)*iterSize;
-			iterStart+=remainder    *(lv.threadId)/lv.threadCount; //spread out by remainder
-			iterEnd  +=(remainder)*(lv.threadId+1)/lv.threadCount; //fill gaps with remaining rows
-				
-			iterEnd = iterEnd > lv.tileRows ? lv.tileRows : iterEnd;
+			size_t iterStart=0;
+			size_t iterEnd=0;
+			threadStripe(lv, iterStart, iterEnd);
+			bool pinned = 0;
+			followPlacement(lv.threadId, pinned);
+			if(placePending){
+				placeThread(lv);
+			}
 
 			while(1){
 				localIterTask=0;
 
-				if(lv.index!=mainCache.index){
-					kaeCache.copyCache(&lv, mainCache);
-				}
 				kaeMutex.waitResume(lv.threadId,&localIterTask,&lv.activeBuf); //wait main thread resume signal
 				
 				if(kaeMutex.isThreadTerminated.load()){
 					return;
 				}
+
+				//backlog runs only while threads wait, so mainCache is stable until next waitResume
+				if(lv.index!=mainCache.index){
+					kaeCache.copyCache(&lv, mainCache);
+					threadStripe(lv, iterStart, iterEnd); //thread count or world size may have changed
+					followPlacement(lv.threadId, pinned); //numaPlacement may have changed
+				}
+
+				if(placePending){ //every pool thread takes part, parked ones too
+					placeThread(lv);
+				}
+
+				if(lv.threadId>=lv.threadCount){ //parked by setThreadCount
+					continue;
+				}
 				
-				for(size_t i=0;i<localIterTask;i++){ //iterate the given amount 
-
-					//iterate stripe of the world
-					for (size_t tx = iterStart; tx < iterEnd; tx++) {
-						//check if tx is near border
-						bool nearBorderX = (tx < lv.maskRadx) || (tx >= lv.tileRows - lv.maskRadx);
-						for (size_t ty = 0; ty < lv.tileCols; ++ty) {
-							iterateCellLV(tx, ty, lv, nearBorderX);
-						}
+				iterateTask(lv, localBarrier, localIterTask, iterStart, iterEnd);
+				if(lv.threadId==0){
+					resultBuf.store(lv.activeBuf);
+				}
+
+				//Ensure very slow threads catch up before entering waitResume()
+				localBarrier.arrive_and_wait(); 
+			}
+		}
+
+		/**
+		 * @brief Pin pool thread to its core
+		*/
+		inline void pinThread(uint threadId) {
+			const uint cpu = numa.threadCpu(threadId);
+			if(!CANuma::pinThread(cpu)){
+				printf("Thread %u couldn't be pinned to CPU %u\n", threadId, cpu);
+			}
+			threadTiming[threadId].node = numa.cpuNode(cpu);
+		}
+
+		/**
+		 * @brief Pin or unpin calling pool thread if numaPlacement changed since the thread last checked
+		 * 
+		 * @param threadId pool thread
+		 * @param pinned whether the thread is pinned, updated to numaPlacement
+		*/
+		inline void followPlacement(const uint threadId, bool &pinned) {
+			if(pinned==numaPlacement){ return; }
+			if(numaPlacement){
+				pinThread(threadId);
+			}else{
+				numa.unpinThread();
+				threadTiming[threadId].node = 0;
+			}
+			pinned = numaPlacement;
+		}
+
+		/**
+		 * @brief Copy the thread's stripe of each cellState buffer to placed, then thread 0 swaps placed to cellState. Every pool thread must call this
+		 * 
+		 * Pages are placed on the node of the thread that touches them first, placed pages are untouched until this copy.
+		 * Runs at pool start and after requestPlacement, so stripes moved by resizeWorld or setThreadCount get their pages moved too.
+		 * Buffers are placed one at a time and the old one is freed before the next is allocated, so at most one extra buffer exists.
+		 * Main thread must not access cellState meanwhile
+		*/
+		inline void placeThread(const ThreadCache &lv) {
+			size_t iterStart=0;
+			size_t iterEnd=0;
+			threadStripe(lv, iterStart, iterEnd); //parked threads have an empty stripe
+			for(int j=0;j<2;j++){
+				if(lv.threadId==0){
+					placed.resize(cellState[j].getRows(), cellState[j].getCols(), cellState[j].getHalo(), 0);
+				}
+				placeBarrier.arrive_and_wait(); //placed is allocated
+				if(iterStart<iterEnd){
+					placed.copyRows(cellState[j], iterStart, iterEnd);
+				}
+				placeBarrier.arrive_and_wait(); //every stripe is copied
+				if(lv.threadId==0){
+					cellState[j].swap(placed);
+					placed.resize(0, 0); //free the old buffer
+				}
+			}
+
+			if(lv.threadId==0){
+				placePending = 0; //every thread read it before the first barrier
+			}
+			placeBarrier.arrive_and_wait(); //nobody iterates before the last swap
+		}
+
+		/**
+		 * @brief Spread lv.threadCount threads to 2D stripes of whole block rows
+		 * 
+		 * Stripe is where a thread starts, idle threads steal block rows of others. Threads past threadCount get an empty stripe
+		*/
+		inline void threadStripe(const ThreadCache &lv, size_t &iterStart, size_t &iterEnd) {
+			if(lv.threadId>=lv.threadCount){
+				iterStart = iterEnd = lv.tileRows;
+				return;
+			}
+			uint iterSize	=(blocksX+lv.threadCount/2)/lv.threadCount;
+			uint remainder	= blocksX%lv.threadCount; //remaining block rows that couldn't be split evenly
+			iterStart	= lv.threadId*iterSize;
+			iterEnd		=(lv.threadId+1)*iterSize;
+			iterStart+=remainder    *(lv.threadId)/lv.threadCount; //spread out by remainder
+			iterEnd  +=(remainder)*(lv.threadId+1)/lv.threadCount; //fill gaps with remaining rows
+
+			iterStart = std::min<size_t>(iterStart*blockRows, lv.tileRows);
+			iterEnd   = std::min<size_t>(iterEnd  *blockRows, lv.tileRows);
+		}
+
+	public:
+		/**
+		 * @brief Iterate rows [iterStart,iterEnd) for iterTask generations
+		 * 
+		 * Every thread must call this with the same iterTask and kernel, stripes synchronize with localBarrier
+		 * Stripes must start at a multiple of blockRows. Only blocks near a changed block are iterated
+		 * Row kernels steal block rows from stripes of other threads, bit engine iterates only its own stripe
+		 * 
+		 * @param lv Unique thread cache
+		 * @param localBarrier barrier of every thread iterating the world
+		 * @param iterTask generations to iterate
+		 * @param iterStart first row of the thread stripe
+		 * @param iterEnd row past the thread stripe
+		*/
+		inline void iterateTask(ThreadCache &lv, CABarrier& localBarrier, const size_t iterTask, const size_t iterStart, const size_t iterEnd) {
+			if(iterTask==0){ return; }
+
+			if constexpr(sizeof(Cell)==1){ //planes and packed stripes hold 8-bit cells
+				if(lv.kernel==CAKernel::KERNEL_HASHLIFE){ //quadtree isn't split to stripes
+					if(lv.threadId==0){
+						hashlife.iterate(cellState, lv.activeBuf, iterTask);
 					}
+					return;
+				}
+
+				if(lv.kernel==CAKernel::KERNEL_CHUNKED){ //threads share chunks instead of stripes
+					threadTiming[lv.threadId].cells.fetch_add(chunks.iterate(cellState, lv, localBarrier, iterTask), std::memory_order_relaxed);
+					return;
+				}
 
-					//Each thread has to be done before next iteration. Otherwise part of the world would simulate at different speed
+				if(lv.kernel==CAKernel::KERNEL_BIT){
+					//world with cells above 1 is iterated with row kernel, which clamps every cell to 0 or 1
+					if(!bitEngine.packRows(cellState[lv.activeBuf], lv.activeBuf, iterStart, iterEnd)){
+						bitEngine.unpackable = 1;
+					}
 					localBarrier.arrive_and_wait(); 
-					threadCloneBuffer(lv);
+					bool packed = !bitEngine.unpackable.load();
+					localBarrier.arrive_and_wait(); //every thread has read unpackable
+					if(lv.threadId==0){
+						bitEngine.unpackable = 0;
+					}
 
+					if(packed){
+						bool packedBuf = lv.activeBuf;
+						ThreadTiming &timing = threadTiming[lv.threadId];
+						for(size_t i=0;i<iterTask;i++){
+							auto workStart = std::chrono::steady_clock::now();
+							bitEngine.iterateRows(lv, packedBuf, iterStart, iterEnd);
+							auto waitStart = std::chrono::steady_clock::now();
+							localBarrier.arrive_and_wait(); 
+							auto waitEnd = std::chrono::steady_clock::now();
+							packedBuf = !packedBuf;
+
+							timing.cells.fetch_add((iterEnd-iterStart)*lv.tileCols, std::memory_order_relaxed);
+							timing.workNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitStart-workStart).count(), std::memory_order_relaxed);
+							timing.waitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd-waitStart).count(), std::memory_order_relaxed);
+						}
+						bitEngine.unpackRows(cellState, packedBuf, iterStart, iterEnd); //both buffers stay equal
+						markOwnBlocks(iterStart, iterEnd); //packed iteration doesn't track blocks
+						return;
+					}
 				}
-				//Ensure very slow threads catch up before entering waitResume()
+			}
+
+			if(lv.temporalDepth>1){
+				iterateTemporal(lv, localBarrier, iterTask, iterStart, iterEnd);
+				markOwnBlocks(iterStart, iterEnd); //tiles don't track blocks
+				return;
+			}
+
+			//blocks that the mask reaches. Partial last block may be narrower than the mask
+			const uint reachX = (lv.maskRadx+blockRows-1)/blockRows + (lv.tileRows%blockRows!=0);
+			const uint reachY = (lv.maskRady+blockCols-1)/blockCols + (lv.tileCols%blockCols!=0);
+			//stripes start at a block row or at tileRows when empty, so both ends round up or an empty stripe owns the partial last block row
+			const uint64_t ownRange = (uint64_t)((iterEnd+blockRows-1)/blockRows)<<32 | ((iterStart+blockRows-1)/blockRows);
+			ThreadTiming &timing = threadTiming[lv.threadId];
+			bool flagBuf = blockFlagBuf;
+			for(size_t i=0;i<iterTask;i++){ //iterate the given amount 
+				auto workStart = std::chrono::steady_clock::now();
+
+				const Cell* readBuf  = cellState[ lv.activeBuf].data();
+				Cell* writeBuf = cellState[!lv.activeBuf].data();
+				const CAGrid<uint8_t> &changedLast = blockChanged[ flagBuf];
+				CAGrid<uint8_t> &changedNow = blockChanged[!flagBuf];
+
+				//own stripe first, then block rows left in other threads stripes
+				stealRanges[lv.threadId].range.store(ownRange, std::memory_order_release);
+				uint victim = lv.threadId;
+				uint bx;
+				size_t cells = 0;
+				while(1){
+					if(!takeBlockRow(victim, victim!=lv.threadId, bx)){
+						victim = (victim+1)%lv.threadCount;
+						if(victim==lv.threadId){ break; } //every range is empty
+						continue;
+					}
+					timing.stolen.fetch_add(victim!=lv.threadId, std::memory_order_relaxed);
+					cells += iterateBlockRow(lv, readBuf, writeBuf, changedLast, changedNow, bx, reachX, reachY);
+				}
+				timing.cells.fetch_add(cells, std::memory_order_relaxed);
+
+				//Each thread has to be done before next iteration. Otherwise part of the world would simulate at different speed
+				auto waitStart = std::chrono::steady_clock::now();
 				localBarrier.arrive_and_wait(); 
+				auto waitEnd = std::chrono::steady_clock::now();
+				lv.activeBuf = !lv.activeBuf; //written buffer is the next generation
+				flagBuf = !flagBuf;
+
+				timing.workNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitStart-workStart).count(), std::memory_order_relaxed);
+				timing.waitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd-waitStart).count(), std::memory_order_relaxed);
+			}
+
+			if(lv.threadId==0){ //every thread has read blockFlagBuf before the first barrier
+				blockFlagBuf = flagBuf;
 			}
 		}
 
-		//Cellular automata iteration logic using ThreadCache lv
 		/**
-		 * @brief Iterate single cellState[Active Buf][ti][tj]
+		 * @brief Temporal blocking. Iterate up to temporalDepth generations per tile between barriers
 		 * 
-		 * @param ti Row
-		 * @param tj Column
-		 * @param nearBorder Is cellState[lv.activeBuf][ti][tj] closer than maskRad from world border
+		 * Tile rows and maskRadx rows per generation on both sides are copied to tileScratch.
+		 * Each generation the outermost maskRadx rows become invalid, so after depth generations only tile rows are valid 
+		 * and they are written to !activeBuf. One round is one barrier, instead of one barrier per generation
+		 * Tiles are taken like block rows in iterateTask, own stripe first then stolen from other threads
 		*/
-		inline void iterateCellLV(const uint ti, const uint tj, CACache::ThreadCache &lv, bool nearBorder){
-
-			int neigsum=0;
-			int addValue=lv.ruleAdd.back();
-			int currentCellState = cellState[lv.activeBuf][ti][tj]; //current cell value
-			int ogState = currentCellState;
-
-			//check if ti,tj is near border
-			nearBorder = nearBorder || (tj < lv.maskRady) || (tj >= lv.tileCols - lv.maskRady );
-			uint nx,ny;
-
-			for(int i=0;i<lv.maskElements;++i){		
-				if(lv.neigMask1d[i]==0){continue;}
-
-				//iterator to coordinate relative to mask center
-				int x=i%lv.maskWidth-lv.maskRadx;
-				int y=i/lv.maskWidth-lv.maskRady;
-
-				//mask cell coordinate in world space, wrapped if out of bound
-				nx = nearBorder ? (ti+x+lv.tileRows)%lv.tileRows : ti+x;
-				ny = nearBorder ? (tj+y+lv.tileCols)%lv.tileCols : tj+y;
-				if(kaelife::CA_DEBUG){
-					if(nx>=lv.tileRows || ny>=lv.tileCols){
-						printf("OUT OF WORLD BOUNDS iterateCellLV0\n");
-						abort();
+		inline void iterateTemporal(ThreadCache &lv, CABarrier& localBarrier, const size_t iterTask, const size_t iterStart, const size_t iterEnd) {
+			//tiles that start in the stripe. Stripes split the world, so tiles are split too
+			const uint64_t ownRange = (uint64_t)((iterEnd+temporalTileRows-1)/temporalTileRows)<<32 | ((iterStart+temporalTileRows-1)/temporalTileRows);
+			ThreadTiming &timing = threadTiming[lv.threadId];
+
+			for(size_t done=0;done<iterTask;){
+				auto workStart = std::chrono::steady_clock::now();
+				const uint depth = std::min<size_t>(lv.temporalDepth, iterTask-done);
+
+				stealRanges[lv.threadId].range.store(ownRange, std::memory_order_release);
+				uint victim = lv.threadId;
+				uint tile;
+				size_t cells = 0;
+				while(1){
+					if(!takeBlockRow(victim, victim!=lv.threadId, tile)){
+						victim = (victim+1)%lv.threadCount;
+						if(victim==lv.threadId){ break; }
+						continue;
 					}
-					if(ti>=lv.tileRows || tj>=lv.tileCols){
-						printf("OUT OF WORLD BOUNDS iterateCellLV1\n");
-						abort();
-					}			
+					timing.stolen.fetch_add(victim!=lv.threadId, std::memory_order_relaxed);
+					cells += iterateTile(lv, tile, depth);
 				}
+				timing.cells.fetch_add(cells, std::memory_order_relaxed);
 
-				uint neigValue=cellState[lv.activeBuf][nx][ny]; //get world cell value
+				auto waitStart = std::chrono::steady_clock::now();
+				localBarrier.arrive_and_wait(); //every tile is written before it is read as activeBuf
+				auto waitEnd = std::chrono::steady_clock::now();
+				lv.activeBuf = !lv.activeBuf;
+				done += depth;
 
-				if(neigValue < lv.clipTreshold){continue;} //clip any values below clipTreshold
-				
-				neigValue=neigValue*lv.neigMask1d[i]/UINT8_MAX; //weight
-				neigsum+=neigValue;
+				timing.workNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitStart-workStart).count(), std::memory_order_relaxed);
+				timing.waitNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd-waitStart).count(), std::memory_order_relaxed);
 			}
+		}
+
+		/**
+		 * @brief Iterate tile rows depth generations from activeBuf to !activeBuf
+		 * 
+		 * @return cells of the tile times depth
+		*/
+		inline size_t iterateTile(ThreadCache &lv, const uint tile, const uint depth) {
+			const size_t x0 = tile*temporalTileRows;
+			const size_t x1 = std::min<size_t>(x0+temporalTileRows, lv.tileRows);
+			const size_t overlap = (size_t)depth*lv.maskRadx;
+			const size_t scratchRows = x1-x0+2*overlap;
 
-			//linear search which range neigsum lands on
-			for(size_t i=0;i<lv.ruleRange.size();i++){
-				if(neigsum<lv.ruleRange[i]){
-					addValue=lv.ruleAdd[i];
-					break;
+			const CAGrid<Cell> &world = cellState[lv.activeBuf];
+			const size_t halo = world.getHalo();
+			CAGrid<Cell> (&scratch)[2] = lv.tileScratch;
+			if(scratch[0].getRows()<scratchRows || scratch[0].getCols()!=lv.tileCols || scratch[0].getHalo()!=halo){
+				for(int j=0;j<2;j++){
+					scratch[j].resize(std::max<size_t>(scratchRows, temporalTileRows+2*temporalMaxDepth*lv.maskRadx), lv.tileCols, halo);
 				}
 			}
+			if(scratch[0].getStride()!=lv.tileStride){
+				printf("tileScratch stride %zu doesn't match cellState stride %zu\n", scratch[0].getStride(), lv.tileStride);
+				abort();
+			}
 
-			currentCellState += addValue;
-			currentCellState = std::clamp(currentCellState, 0, (int)(lv.stateCount) - 1);
-			if(ogState == currentCellState){return;}
-			lv.updatedCells[0].push_back(ti);
-			lv.updatedCells[1].push_back(tj);
-			cellState[!lv.activeBuf][ti][tj] = currentCellState; //write to inactive buffer
+			//tile and overlap rows, row halo included. Rows past the world wrap around
+			const size_t rowBytes = (lv.tileCols+2*halo)*sizeof(Cell);
+			for(size_t sx=0;sx<scratchRows;sx++){
+				const size_t wx = (x0+sx+(lv.tileRows-1)*overlap)%lv.tileRows; //x0+sx-overlap wrapped
+				std::memcpy(scratch[0][sx]-halo, world[wx]-halo, rowBytes);
+			}
+
+			//ping-pong in scratch. Rows outside [sx0,sx1) are stale, but only stale rows read them
+			bool cur = 0;
+			for(uint gen=1;gen<=depth;gen++){
+				const size_t sx0 = (size_t)gen*lv.maskRadx;
+				const size_t sx1 = scratchRows-sx0;
+				for(size_t sx=sx0;sx<sx1;sx++){
+					CAKernel::iterateRow(lv, scratch[cur].data(), scratch[!cur].data(), sx, 0, lv.tileCols);
+					scratch[!cur].refreshRowHalo(sx);
+				}
+				cur = !cur;
+			}
+
+			CAGrid<Cell> &next = cellState[!lv.activeBuf];
+			for(size_t tx=x0;tx<x1;tx++){
+				std::memcpy(next[tx], scratch[cur][tx-x0+overlap], lv.tileCols*sizeof(Cell));
+				next.refreshRowHalo(tx);
+			}
+			return (x1-x0)*lv.tileCols*depth;
 		}
+
+		/**
+		 * @brief Iterate blocks of block row bx whose neighborhood changed
+		 * 
+		 * Block row is the work stealing unit, any thread may iterate any block row once per iteration
+		 * 
+		 * @return cells of iterated blocks
+		*/
+		inline size_t iterateBlockRow(ThreadCache &lv, const Cell* readBuf, Cell* writeBuf, 
+			const CAGrid<uint8_t> &changedLast, CAGrid<uint8_t> &changedNow, const uint bx, const uint reachX, const uint reachY) {
+			const size_t x0 = bx*blockRows;
+			const size_t x1 = std::min<size_t>(x0+blockRows, lv.tileRows);
+			size_t cells = 0;
+			for (uint by = 0; by < blocksY; by++) {
+				uint8_t &blockFlag = changedNow[bx][by];
+				//unchanged neighborhood gives the same cells as last iteration, 
+				//which writeBuf already holds from the iteration before because the block didn't change either
+				if(!blockNeighborChanged(changedLast, bx, by, reachX, reachY)){
+					blockFlag = 0;
+					continue;
+				}
+				const uint y0 = by*blockCols;
+				const uint y1 = std::min(y0+blockCols, lv.tileCols);
+				bool changed = 0;
+				for (size_t tx = x0; tx < x1; tx++) {
+					changed |= CAKernel::iterateRow(lv, readBuf, writeBuf, tx, y0, y1);
+				}
+				blockFlag = changed;
+				cells += (x1-x0)*(y1-y0);
+			}
+			if(cells==0){ return 0; }
+			//mirror finished rows to halo. Next iteration reads them from this buffer
+			for (size_t tx = x0; tx < x1; tx++) {
+				cellState[!lv.activeBuf].refreshRowHalo(tx);
+			}
+			return cells;
+		}
+
+		/**
+		 * @brief Mark blocks of stripe [iterStart,iterEnd) changed in both blockChanged buffers
+		*/
+		inline void markOwnBlocks(const size_t iterStart, const size_t iterEnd) {
+			for(int j=0;j<2;j++){
+				blockChanged[j].fillRows((iterStart+blockRows-1)/blockRows, (iterEnd+blockRows-1)/blockRows, 1); //empty stripe marks nothing, see ownRange
+			}
+		}
+
 	//EOF iterate functions
 
 	public:
+	/**
+	 * @brief Select next CAKernel::KernelType preference. Not thread safe
+	 * 
+	 * @return kernel that iterates the current preset
+	*/
+	uint nextKernel(){
+		kernelPreference = (CAKernel::KernelType)((kernelPreference+1)%CAKernel::KERNEL_COUNT);
+		loadPreset();
+		return mainCache.kernel;
+	}
+
+	/**
+	 * @brief Set number of iterating threads. Not thread safe
+	 * 
+	 * Pool threads past the count stay parked in waitResume, so the world is repartitioned without restarting threads
+	 * 
+	 * @param count clamped to [1,poolSize]
+	 * @return iterating thread count
+	*/
+	uint setThreadCount(uint count){
+		mainCache.threadCount = std::clamp<uint>(count, 1, poolSize);
+		iterBarrier.setCount(mainCache.threadCount);
+		mainCache.index++; //threads copy the new count and their stripe
+		requestPlacement(); //stripes moved, pages follow them
+		return mainCache.threadCount;
+	}
+
+	/**
+	 * @brief Turn NUMA thread pinning and first touch placement on or off. Not thread safe
+	 * 
+	 * Pool threads pin or unpin themselves with the next task. Turning it on places cellState again
+	 * 
+	 * @return numaPlacement
+	*/
+	bool setNumaPlacement(bool on){
+		numaPlacement = on;
+		mainCache.index++; //threads check numaPlacement with the cache copy
+		requestPlacement();
+		return numaPlacement;
+	}
+
+	/**
+	 * @brief Double temporalDepth up to temporalMaxDepth, then back to 1. Not thread safe
+	 * 
+	 * @return generations per temporal blocking round
+	*/
+	uint nextTemporalDepth(){
+		mainCache.temporalDepth = mainCache.temporalDepth>=temporalMaxDepth ? 1 : mainCache.temporalDepth*2;
+		mainCache.index++; //threads copy the new depth
+		return mainCache.temporalDepth;
+	}
+
 	//BOF cellState functions
 	
-	//randomize state[!activeBuf][][]. Not thread safe
+	//randomize state[activeBuf][][]. Not thread safe
 	/**
 	 * @param numStates number of possible automata states
 	 * @param seed randomizer seed. If no seed is given, use kaelife::rand() instance seed
 	*/
 	void randState(uint numStates, uint64_t* seed=nullptr ){
 		uint64_t* seedPtr = kaelife::rand.validSeedPtr(seed);
+		CAGrid<Cell> &grid = cellState[mainCache.activeBuf];
 		for(uint i=0;i<mainCache.tileRows;i++){
+			Cell* row = grid[i];
 			for(uint j=0;j<mainCache.tileCols;j++){
-				cellState[!mainCache.activeBuf][i][j]=kaelife::rand(seedPtr)%numStates;
+				row[j]=kaelife::rand(seedPtr)%numStates;
 			}
 		}
 	}
 	//EOF cellState functions
 };
 
+/** @brief Default 8-bit world */
+typedef CADataT<uint8_t> CAData;
+/** @brief World of up to 65536 states. Twice the memory traffic of CAData */
+typedef CADataT<uint16_t> CAData16;
+
 //include here to prevent circular dependency
 #include "kaelifeCABacklog.hpp"
 
 /**
  * @brief CAData constructor and initialization
 */
-CAData::CAData() {
-    backlog = std::make_unique<CABacklog>(*this);
+template<typename Cell>
+CADataT<Cell>::CADataT(uint rows, uint cols, uint64_t maxBytes) {
+    backlog = std::make_unique<CABacklogT<Cell>>(*this);
+
+	maxWorldBytes = maxBytes ? maxBytes : defaultMaxWorldBytes();
+	rows = std::max(rows, 1u);
+	cols = std::max(cols, 1u);
+	if(!worldFits(rows, cols)){
+		const uint askedRows = rows;
+		const uint askedCols = cols;
+		while(!worldFits(rows, cols) && (rows>1 || cols>1)){ //same rule as resizeWorld, halved like [-]
+			rows = std::max(rows/2, 1u);
+			cols = std::max(cols/2, 1u);
+		}
+		printf("World %ux%u exceeds %lu MiB, using %ux%u\n", askedRows, askedCols, maxWorldBytes>>20, rows, cols);
+	}
 
 	mainCache.threadId		=	UINT_MAX; //only threads use this
 	mainCache.activeBuf		=	0;
-	mainCache.tileRows		=	576; 
-	mainCache.tileCols		=	384;
+	mainCache.tileRows		=	rows;
+	mainCache.tileCols		=	cols;
 	mainCache.threadCount	=	std::thread::hardware_concurrency();
 	if(mainCache.threadCount>mainCache.tileCols){mainCache.threadCount=mainCache.tileCols;}
+	mainCache.threadCount	=	std::max(mainCache.threadCount, 1u); //hardware_concurrency may be 0 if unknown
+	poolSize				=	mainCache.threadCount;
+	numaPlacement			=	numa.nodeCount()>1;
 
 	aspectRatio=(float)mainCache.tileRows/mainCache.tileCols;
 	if(true){
-		renderWidth = mainCache.tileRows*2 ;
-		renderHeight = mainCache.tileCols*2;
+		float renderScale = std::min(2.0f, (float)maxRenderSize/std::max(mainCache.tileRows, mainCache.tileCols));
+		renderWidth = std::max<uint>(mainCache.tileRows*renderScale, 1);
+		renderHeight = std::max<uint>(mainCache.tileCols*renderScale, 1);
 	}else{
 		renderWidth = mainCache.tileRows>1024 ? mainCache.tileRows : 1024 ;
 		renderHeight = renderWidth/aspectRatio;
 	}
 
 	for (int j = 0; j < 2; j++) {
-		cellState[j].resize(mainCache.tileRows);
-		for (uint i = 0; i < mainCache.tileRows; i++) {
-			cellState[j][i].resize(mainCache.tileCols);
-		}
+		cellState[j].resize(mainCache.tileRows, mainCache.tileCols, defaultHalo);
 	}
+	resizeBlocks();
+	resizeThreadSlots(poolSize);
 
 	targetFrameTime= targetFrameTime<=0.0 ? 0.000001 : targetFrameTime;
 
-	CAPreset::RulePreset bufPreset("RANDOM");
+	typename CAPresetT<Cell>::RulePreset bufPreset("RANDOM");
 	uint randIndex = kaePreset.addPreset(bufPreset);
 	kaePreset.seedFromName(randIndex);
 
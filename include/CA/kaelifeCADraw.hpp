@@ -6,12 +6,11 @@
 
 #pragma once
 
-#include "kaelife.hpp"
 #include "kaelifeCAData.hpp" 
 #include "kaelRandom.hpp"
 #include "kaelifeCACache.hpp"
+#include "kaelifeCAGrid.hpp"
 
-#include <SDL2/SDL.h>
 #include <map>
 #include <functional>
 #include <algorithm>
@@ -33,15 +32,15 @@ private:
 	 * @brief pixels to be cloned to cellState
 	*/
 	struct drawnPixel{
-		uint16_t pos[2]; //list of coordinates to update {{123,23},...,{3,7}}
-		uint8_t state;
+		uint32_t pos[2]; //list of coordinates to update {{123,23},...,{3,7}}
+		uint16_t state; //fits every cell type
 	};
 
 	/**
 	 * @brief center of drawn circles
 	*/
 	struct drawnPoint{
-		uint16_t pos[2];
+		uint32_t pos[2];
 		uint8_t radius;
 	};
 
@@ -64,10 +63,10 @@ private:
 	/**
 	 * @brief Check if pixel is already in buffer for this frame
 	*/
-	bool alreadyDrawn(uint16_t ax, uint16_t ay) {
+	bool alreadyDrawn(uint32_t ax, uint32_t ay) {
 		for (size_t i = 0; i < drawBuf.points.size(); ++i) {
-			int64_t deltaX = (int)drawBuf.points[i].pos[0]-ax;
-			int64_t deltaY = (int)drawBuf.points[i].pos[1]-ay;
+			int64_t deltaX = (int64_t)drawBuf.points[i].pos[0]-ax;
+			int64_t deltaY = (int64_t)drawBuf.points[i].pos[1]-ay;
 			deltaX*=deltaX;
 			deltaY*=deltaY;			
 			int radSq = drawBuf.points[i].radius*drawBuf.points[i].radius;
@@ -92,7 +91,8 @@ public:
 	 * @param cache main thread cache
 	 * 
 	*/
-	void cursorDraw(int strength, int cursorX, int cursorY, int drawRadius, bool drawRandom, CACache::ThreadCache cache) {
+	template<typename Cell>
+	void cursorDraw(int strength, int cursorX, int cursorY, int drawRadius, bool drawRandom, CACache::ThreadCacheT<Cell> cache) {
 		std::lock_guard<std::mutex> lock(drawBuf.mtx); //make sure drawBuf is not being copied while drawing
 		uint numStates = cache.stateCount;
 
@@ -100,12 +100,12 @@ public:
 			//this only discards if this and previous positions are the same. 
 			//With big canvas it's unlikely to have two exact same positions, 
 			//and calculating the duplicates has marginal performance impact compared to std::find
-			if( ( drawBuf.points.back().pos[0]==cursorX && drawBuf.points.back().pos[1]==cursorY ) ) { 
+			if( ( drawBuf.points.back().pos[0]==(uint32_t)cursorX && drawBuf.points.back().pos[1]==(uint32_t)cursorY ) ) { 
 				return;
 			}
 		}
 
-		uint8_t drawValue=ceil(strength * (numStates - 1) * strength);
+		Cell drawValue=ceil(strength * (numStates - 1) * strength);
 
 		for (int i = -drawRadius; i <= drawRadius; i++) {
 			for (int j = -drawRadius; j <= drawRadius; j++) {
@@ -115,8 +115,8 @@ public:
 				if(mouseDist >= radSq ){continue;} //if outside the circle, discard
 
 				//calculate point of the circle world position 
-				uint16_t ax = ((int)cursorX + i + cache.tileRows) % cache.tileRows;
-				uint16_t ay = ((int)cursorY + j + cache.tileCols) % cache.tileCols;
+				uint32_t ax = ((int)cursorX + i + cache.tileRows) % cache.tileRows;
+				uint32_t ay = ((int)cursorY + j + cache.tileCols) % cache.tileCols;
 				if ( alreadyDrawn(ax, ay) ) { continue; }
 				drawSeed++;
 				if(drawRandom) { drawValue = (kaelife::rand(&drawSeed))%numStates; }
@@ -132,7 +132,7 @@ public:
 
 		//store cursor position. alreadyDrawn() uses this to determine if pixels were already drawn on the same frame
 		drawnPoint cursorPosHistory = {
-			.pos={ (uint16_t)cursorX, (uint16_t)cursorY },
+			.pos={ (uint32_t)cursorX, (uint32_t)cursorY },
 			.radius=(uint8_t)drawRadius
 		};
 		drawBuf.points.push_back(cursorPosHistory);
@@ -144,14 +144,15 @@ public:
 	 * 
 	 * @note CAData iteration threads must be paused before copyDrawBuf call
 	*/
-	uint copyDrawBuf(std::vector<std::vector<uint8_t>> &cellState, CACache::ThreadCache cache){
+	template<typename Cell>
+	uint copyDrawBuf(CAGrid<Cell> &cellState, CACache::ThreadCacheT<Cell> cache){
 		std::lock_guard<std::mutex> lock(drawBuf.mtx);//wait till drawing is done
 
 		if(drawBuf.pixels.empty()){	return 0; } //This was previously outside mutex lock which was potential cause for "attempt to copy from a singular iterator"
 
 		for (const auto& pixel : drawBuf.pixels) {
-			uint16_t x = pixel.pos[0]%cache.tileRows;
-			uint16_t y = pixel.pos[1]%cache.tileCols;
+			uint32_t x = pixel.pos[0]%cache.tileRows;
+			uint32_t y = pixel.pos[1]%cache.tileCols;
 
 			if(kaelife::CA_DEBUG){
 				if(x>=cache.tileRows || y>=cache.tileCols){
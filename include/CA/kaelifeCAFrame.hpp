@@ -0,0 +1,76 @@
+/**
+ * @file kaelifeCAFrame.hpp
+ *
+ * @brief CAData finished generations published to the renderer
+*/
+
+#pragma once
+
+#include "kaelifeCAGrid.hpp"
+
+#include <iostream>
+#include <cstdint>
+#include <atomic>
+
+/**
+ * @brief Lock free triple buffer of world frames. One writer publishes, one reader acquires
+ *
+ * Writer fills back() and publish() swaps it with the middle frame. Reader acquire() swaps the middle frame
+ * to front only if a newer one was published, so neither side ever waits for the other.
+ * Reader may skip frames if the writer is faster, and sees the same frame again if the writer is slower.
+ * Writer may resize back() cells, so frames of different dimensions can be in flight
+ *
+ * @tparam Cell cellState cell type
+*/
+template<typename Cell>
+class CAFrameBufferT {
+public:
+	/**
+	 * @brief One published world
+	*/
+	struct Frame {
+		CAGrid<Cell> cells; //world cells without halo
+		uint stateCount = 0; //preset states when the frame was published
+		uint64_t generation = 0; //CAData::generation when the frame was published
+	};
+
+	/**
+	 * @brief Frame that only the writer may fill
+	*/
+	inline Frame& back() {
+		return frames[backIndex];
+	}
+
+	/**
+	 * @brief Writer hands back() to the reader and takes the frame that the reader didn't take
+	*/
+	inline void publish() {
+		const uint8_t old = middle.exchange(backIndex | freshBit, std::memory_order_acq_rel);
+		backIndex = old & indexMask;
+	}
+
+	/**
+	 * @brief Reader takes the newest published frame. Valid until next acquire
+	*/
+	inline const Frame& acquire() {
+		if(middle.load(std::memory_order_relaxed) & freshBit){
+			const uint8_t old = middle.exchange(frontIndex, std::memory_order_acq_rel);
+			frontIndex = old & indexMask;
+		}
+		return frames[frontIndex];
+	}
+
+private:
+	static constexpr const uint8_t indexMask = 0b011;
+	static constexpr const uint8_t freshBit  = 0b100; //middle frame wasn't acquired yet
+
+	Frame frames[3];
+	alignas(64) uint8_t backIndex = 0; //writer private
+	alignas(64) uint8_t frontIndex = 1; //reader private
+	alignas(64) std::atomic<uint8_t> middle = 2; //frame index and freshBit
+};
+
+/**
+ * @brief Frames of the default 8-bit world
+*/
+typedef CAFrameBufferT<uint8_t> CAFrameBuffer;
@@ -0,0 +1,256 @@
+/**
+ * @file kaelifeCAGrid.hpp
+ *
+ * @brief CAData contiguous 64-byte aligned world grid
+*/
+
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+template <typename T>
+/**
+ * @brief Single contiguous 2D world grid. One allocation per grid
+ *
+ * Memory layout is row major in world space X, same as the old cellState[X][Y]
+ * Each row X holds getCols() Y values followed by padding up to getStride()
+ * Every row start is aligned to 64 bytes so a row can be streamed with aligned loads
+ *
+ * The grid can reserve halo (ghost) rows and columns of width getHalo() around the world.
+ * Halo cells are part of the allocation and can be addressed with negative or past the end indices
+ *
+ * @code
+ * CAGrid<uint8_t> grid(576, 384);
+ * grid[x][y] = 3; //same syntax as std::vector<std::vector<uint8_t>>
+ * uint8_t* row = grid[x]; //pointer to grid[x][0]
+ * @endcode
+ *
+ * @tparam T Type of the cells.
+ */
+class CAGrid {
+public:
+	static constexpr const size_t alignment = 64; //cache line
+
+	CAGrid() {}
+
+	/**
+	 * @brief Allocate zeroed rows*cols grid
+	 *
+	 * @param rows world X dimension
+	 * @param cols world Y dimension
+	 * @param halo ghost cells around every side
+	*/
+	CAGrid(size_t rows, size_t cols, size_t halo=0) {
+		resize(rows, cols, halo);
+	}
+
+	CAGrid(const CAGrid& other) {
+		*this = other;
+	}
+
+	CAGrid(CAGrid&& other) noexcept {
+		swap(other);
+	}
+
+	~CAGrid() {
+		std::free(buffer);
+	}
+
+	/**
+	 * @brief Deep copy. Reallocates only if dimensions differ
+	*/
+	CAGrid& operator=(const CAGrid& other) {
+		if(this==&other){ return *this; }
+		if(	rows!=other.rows || cols!=other.cols || halo!=other.halo ){
+			resize(other.rows, other.cols, other.halo);
+		}
+		if(buffer){
+			std::memcpy(buffer, other.buffer, allocSize());
+		}
+		return *this;
+	}
+
+	CAGrid& operator=(CAGrid&& other) noexcept {
+		swap(other);
+		return *this;
+	}
+
+	void swap(CAGrid& other) noexcept {
+		std::swap(buffer, other.buffer);
+		std::swap(origin, other.origin);
+		std::swap(rows, other.rows);
+		std::swap(cols, other.cols);
+		std::swap(halo, other.halo);
+		std::swap(padLeft, other.padLeft);
+		std::swap(stride, other.stride);
+	}
+
+	/**
+	 * @brief Reallocate grid. Old content is discarded and every cell is zeroed
+	 *
+	 * @param newRows world X dimension
+	 * @param newCols world Y dimension
+	 * @param newHalo ghost cells around every side
+	 * @param zero if false, content is undefined and pages stay untouched until copyRows, so each thread can first touch its own rows
+	*/
+	void resize(size_t newRows, size_t newCols, size_t newHalo=0, bool zero=true) {
+		std::free(buffer);
+		buffer = nullptr;
+		origin = nullptr;
+
+		rows = newRows;
+		cols = newCols;
+		halo = newHalo;
+
+		constexpr size_t alignCells = alignment/sizeof(T);
+		padLeft = (halo+alignCells-1)/alignCells*alignCells; //keep grid[x][0] aligned
+		stride  = (padLeft+cols+halo+alignCells-1)/alignCells*alignCells;
+
+		if(rows==0 || cols==0){ return; }
+
+		buffer = static_cast<T*>(std::aligned_alloc(alignment, allocSize()));
+		if(buffer==nullptr){
+			printf("CAGrid allocation failed %lu bytes\n", allocSize());
+			abort();
+		}
+		if(zero){
+			std::memset(buffer, 0, allocSize());
+		}
+		origin = buffer + halo*stride + padLeft;
+	}
+
+	/**
+	 * @brief Copy padded rows [x0,x1) from a grid of equal dimensions. Ghost rows are copied with the first and last row
+	 *
+	 * Rows are independent, so threads may copy their own rows
+	*/
+	void copyRows(const CAGrid& src, size_t x0, size_t x1) {
+		const ptrdiff_t first = x0==0 ? -(ptrdiff_t)halo : x0;
+		const ptrdiff_t last  = x1==rows ? rows+halo : x1;
+		if(first>=last){ return; }
+		std::memcpy((*this)[first]-padLeft, src[first]-padLeft, (last-first)*stride*sizeof(T));
+	}
+
+	/**
+	 * @brief Change halo width and keep the world cells
+	 *
+	 * @param newHalo ghost cells around every side
+	*/
+	void setHalo(size_t newHalo) {
+		if(newHalo==halo){ return; }
+		CAGrid<T> old;
+		swap(old);
+		resize(old.rows, old.cols, newHalo);
+		for(size_t x=0;x<rows;++x){
+			std::memcpy((*this)[x], old[x], cols*sizeof(T));
+		}
+		refreshHalo();
+	}
+
+	/**
+	 * @brief Copy the toroidally wrapped world into every halo cell
+	*/
+	void refreshHalo() {
+		if(halo==0 || buffer==nullptr){ return; }
+		for(size_t x=0;x<rows;++x){
+			refreshRowHalo(x);
+		}
+	}
+
+	/**
+	 * @brief Refresh halo cells that mirror row x
+	 *
+	 * Wraps the row's Y ends into its halo columns, then copies the full padded row 
+	 * into halo rows that wrap back to x. Rows are independent so each thread may refresh its own rows
+	 *
+	 * @param x world row. Must be completely written before refresh
+	*/
+	inline void refreshRowHalo(const size_t x) {
+		if(halo==0){ return; }
+		T* row = (*this)[x];
+		const ptrdiff_t c = cols;
+		const ptrdiff_t h = halo;
+		for(ptrdiff_t i=1;i<=h;++i){
+			row[-i]		= row[((-i)%c+c)%c];
+			row[c-1+i]	= row[(c-1+i)%c];
+		}
+
+		const ptrdiff_t r = rows;
+		const ptrdiff_t rx = x;
+		const size_t rowBytes = (2*halo+cols)*sizeof(T);
+		for(ptrdiff_t g=rx+r; g<r+h; g+=r){ //ghost rows past the end
+			std::memcpy((*this)[g]-halo, row-halo, rowBytes);
+		}
+		for(ptrdiff_t g=rx-r; g>=-h; g-=r){ //ghost rows before the start
+			std::memcpy((*this)[g]-halo, row-halo, rowBytes);
+		}
+	}
+
+	/**
+	 * @brief Set world cells of rows [x0,x1) to value. Halo and padding are not touched
+	*/
+	void fillRows(size_t x0, size_t x1, const T value) {
+		for(size_t x=x0;x<x1;++x){
+			std::fill((*this)[x], (*this)[x]+cols, value);
+		}
+	}
+
+	/**
+	 * @brief Zero every cell, halo included
+	*/
+	void clear() {
+		if(buffer){ std::memset(buffer, 0, allocSize()); }
+	}
+
+	/**
+	 * @brief Row pointer. grid[x][y]
+	 *
+	 * @note No bounds check. x and y may reach into the halo
+	*/
+	inline T* operator[](const ptrdiff_t x) {
+		return origin + x*(ptrdiff_t)stride;
+	}
+
+	/**
+	 * @brief Const row pointer. grid[x][y]
+	*/
+	inline const T* operator[](const ptrdiff_t x) const {
+		return origin + x*(ptrdiff_t)stride;
+	}
+
+	/**
+	 * @return pointer to grid[0][0]
+	*/
+	inline T* data() { return origin; }
+	/**
+	 * @return const pointer to grid[0][0]
+	*/
+	inline const T* data() const { return origin; }
+
+	/** @brief world X dimension */
+	inline size_t getRows() const { return rows; }
+	/** @brief world Y dimension */
+	inline size_t getCols() const { return cols; }
+	/** @brief distance in cells between grid[x][0] and grid[x+1][0] */
+	inline size_t getStride() const { return stride; }
+	/** @brief ghost cells around every side */
+	inline size_t getHalo() const { return halo; }
+
+private:
+	T* buffer = nullptr; //aligned allocation, halo rows included
+	T* origin = nullptr; //grid[0][0]
+	size_t rows = 0;
+	size_t cols = 0;
+	size_t halo = 0;
+	size_t padLeft = 0; //cells before grid[x][0], rounded up to alignment
+	size_t stride = 0;
+
+	inline size_t allocSize() const {
+		return (rows+2*halo)*stride*sizeof(T);
+	}
+};
@@ -0,0 +1,399 @@
+/**
+ * @file kaelifeCAHashlife.hpp
+ *
+ * @brief CAData memoized quadtree iteration of unbounded worlds
+*/
+
+#pragma once
+
+#include "kaelRandom.hpp"
+#include "kaelifeCACache.hpp"
+#include "kaelifeCAGrid.hpp"
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+/**
+ * @brief Hashlife engine. World is an unbounded plane stored as a quadtree of hashed and shared nodes
+ *
+ * Node of level k is a 2^k*2^k square. Level 0 nodes are the 256 cell values.
+ * Equal squares are the same node, so repeating or empty areas cost one node per level.
+ * nextGen of a node is its center square some generations later, memoized in the node,
+ * so a pattern that repeats in space or time is computed once.
+ *
+ * cellState is a viewport of the plane, rows*cols cells centered at plane origin.
+ * The plane doesn't wrap like cellState, cells leaving the viewport keep living outside it.
+ *
+ * Works for masks of at most 3x3 and rules that keep empty areas empty
+*/
+class CAHashlife {
+public:
+	CAHashlife() {
+		reset();
+	}
+
+	/**
+	 * @brief Whether preset in cache can be iterated by quadtree. Needs compiled ruleNext
+	*/
+	static bool fits(const CACache::ThreadCache &cache) {
+		if(cache.maskWidth>3 || cache.maskHeight>3){ return 0; } //nextGen assumes 1 cell per generation speed
+		if(cache.ruleNext.empty() || cache.ruleOffset.empty()){ return 0; }
+		return cache.ruleNext[cache.ruleOffset[0]]==0; //empty plane must stay empty
+	}
+
+	/**
+	 * @brief Copy taps and rules of a fitting preset. Forgets memoized generations
+	 *
+	 * @param cache mainCache with loaded neigMask1d, weightTables and rule tables
+	*/
+	void compileRules(const CACache::ThreadCache &cache) {
+		taps.clear();
+		uint tapInd = 0; //maskTaps are the non-zero neigMask1d elements in order
+		for(uint i=0;i<cache.maskElements;++i){
+			if(cache.neigMask1d[i]==0){continue;}
+			int x=i%cache.maskWidth-cache.maskRadx;
+			int y=i/cache.maskWidth-cache.maskRady;
+			taps.push_back({(int8_t)x, (int8_t)y, cache.maskTaps[tapInd++].table});
+		}
+		weightTables = cache.weightTables;
+		ruleNext = cache.ruleNext;
+		ruleOffset = cache.ruleOffset;
+		forgetResults();
+	}
+
+	/**
+	 * @brief Empty plane and free every node
+	*/
+	void reset() {
+		nodes.clear();
+		nodeMap.clear();
+		emptyNode.clear();
+		for(uint v=0;v<=UINT8_MAX;v++){
+			nodes.push_back({{0,0,0,0}, noResult, 0, noStep});
+		}
+		emptyNode.push_back(0);
+		root = empty(3);
+		viewDirty = 1;
+	}
+
+	/**
+	 * @brief Replace viewport of the plane with grid before the next iterate. Not thread safe
+	*/
+	void markViewDirty() {
+		viewDirty = 1;
+	}
+
+	/**
+	 * @brief Advance the plane by generations and write the viewport to both grids
+	 *
+	 * @param grids cellState
+	 * @param activeBuf grid that is imported if the viewport was changed
+	 * @param generations any count, done as power of 2 steps
+	*/
+	void iterate(CAGrid<uint8_t> (&grids)[2], const bool activeBuf, const size_t generations) {
+		if(nodes.size() > maxNodes){
+			collect();
+		}
+		if(viewDirty){
+			importView(grids[activeBuf]);
+			viewDirty = 0;
+		}
+		for(uint s=0; (generations>>s)!=0; s++){
+			if(generations>>s & 1){
+				advance(s);
+			}
+		}
+		exportView(grids);
+	}
+
+	/** @brief Node count, shared nodes included once */
+	size_t nodeCount() const { return nodes.size(); }
+	/** @brief Quadtree height. Plane covers 2^rootLevel cells per side */
+	uint rootLevel() const { return nodes[root].level; }
+
+private:
+	static constexpr const uint32_t noResult = UINT32_MAX;
+	static constexpr const uint8_t noStep = UINT8_MAX;
+	static constexpr const size_t maxNodes = 1<<23; //garbage collect above this many nodes
+
+	/**
+	 * @brief Quadtree node. Children are 00 01 10 11 in world X then Y order
+	*/
+	struct Node {
+		uint32_t child[4];
+		uint32_t result; //nextGen with 2^resultStep generations
+		uint8_t level;
+		uint8_t resultStep;
+	};
+
+	struct Tap {
+		int8_t x;
+		int8_t y;
+		uint16_t table; //weightTables offset
+	};
+
+	typedef std::array<uint32_t,4> NodeKey;
+	struct NodeHash {
+		size_t operator()(const NodeKey &key) const {
+			uint64_t hash = 0;
+			for(const uint32_t child : key){
+				hash = kaelife::rand((uint64_t)(hash + child));
+			}
+			return hash;
+		}
+	};
+
+	std::vector<Node> nodes;
+	std::unordered_map<NodeKey, uint32_t, NodeHash> nodeMap;
+	std::vector<uint32_t> emptyNode; //empty node of each level
+	uint32_t root = 0;
+	bool viewDirty = 1;
+
+	std::vector<Tap> taps;
+	std::vector<uint8_t> weightTables;
+	std::vector<uint8_t> ruleNext;
+	std::vector<uint16_t> ruleOffset;
+
+	/**
+	 * @brief Shared node with these children
+	*/
+	uint32_t join(const uint32_t c00, const uint32_t c01, const uint32_t c10, const uint32_t c11) {
+		NodeKey key = {c00, c01, c10, c11};
+		auto it = nodeMap.find(key);
+		if(it!=nodeMap.end()){ return it->second; }
+		uint32_t ind = nodes.size();
+		nodes.push_back({{c00, c01, c10, c11}, noResult, (uint8_t)(nodes[c00].level+1), noStep});
+		nodeMap.emplace(key, ind);
+		return ind;
+	}
+
+	uint32_t empty(const uint level) {
+		while(emptyNode.size()<=level){
+			uint32_t e = emptyNode.back();
+			emptyNode.push_back(join(e,e,e,e));
+		}
+		return emptyNode[level];
+	}
+
+	inline uint32_t child(const uint32_t node, const uint i) const {
+		return nodes[node].child[i];
+	}
+
+	/**
+	 * @brief Level k-1 node centered in level k node
+	*/
+	uint32_t center(const uint32_t n) {
+		return join(child(child(n,0),3), child(child(n,1),2), child(child(n,2),1), child(child(n,3),0));
+	}
+
+	/**
+	 * @brief Level k-1 node centered between level k nodes a and b. Adjacent in Y if alongY, else in X
+	*/
+	uint32_t centerBetween(const uint32_t a, const uint32_t b, const bool alongY) {
+		if(alongY){
+			return join(child(a,1), child(b,0), child(a,3), child(b,2));
+		}
+		return join(child(a,2), child(a,3), child(b,0), child(b,1));
+	}
+
+	/**
+	 * @brief Center 2*2 of level 2 node after one generation
+	*/
+	uint32_t baseGen(const uint32_t n) {
+		uint8_t cell[4][4];
+		for(uint x=0;x<4;x++){
+			for(uint y=0;y<4;y++){
+				cell[x][y] = child(child(n, (x>>1)*2+(y>>1)), (x&1)*2+(y&1));
+			}
+		}
+		uint32_t next[4];
+		for(uint x=1;x<3;x++){
+			for(uint y=1;y<3;y++){
+				uint neigsum = 0;
+				for(const Tap &tap : taps){
+					neigsum += weightTables[tap.table + cell[x+tap.x][y+tap.y]];
+				}
+				next[(x-1)*2+(y-1)] = ruleNext[ruleOffset[neigsum] + cell[x][y]];
+			}
+		}
+		return join(next[0], next[1], next[2], next[3]);
+	}
+
+	/**
+	 * @brief Center of level k node after 2^min(step,k-2) generations
+	*/
+	uint32_t nextGen(const uint32_t n, const uint step) {
+		if(nodes[n].resultStep==step){ return nodes[n].result; }
+		const uint level = nodes[n].level;
+		if(n==empty(level)){ return empty(level-1); }
+
+		uint32_t result;
+		if(level==2){
+			result = baseGen(n);
+		}else{
+			const uint32_t c00=child(n,0), c01=child(n,1), c10=child(n,2), c11=child(n,3);
+			//9 overlapping level k-1 nodes
+			uint32_t sub[9] = {
+				c00, centerBetween(c00,c01,1), c01,
+				centerBetween(c00,c10,0), center(n), centerBetween(c01,c11,0),
+				c10, centerBetween(c10,c11,1), c11
+			};
+			const bool fullStep = step >= level-2;
+			for(uint i=0;i<9;i++){ //full step advances twice, half each
+				sub[i] = fullStep ? nextGen(sub[i], step) : center(sub[i]);
+			}
+			uint32_t quad[4];
+			for(uint i=0;i<4;i++){
+				const uint s = (i>>1)*3 + (i&1);
+				quad[i] = nextGen(join(sub[s], sub[s+1], sub[s+3], sub[s+4]), step);
+			}
+			result = join(quad[0], quad[1], quad[2], quad[3]);
+		}
+		nodes[n].result = result;
+		nodes[n].resultStep = step;
+		return result;
+	}
+
+	/**
+	 * @brief Same plane one level higher
+	*/
+	uint32_t expand(const uint32_t n) {
+		const uint32_t e = empty(nodes[n].level-1);
+		return join(
+			join(e, e, e, child(n,0)), join(e, e, child(n,1), e),
+			join(e, child(n,2), e, e), join(child(n,3), e, e, e)
+		);
+	}
+
+	/**
+	 * @brief Whether every cell of level k node is in its center level k-1 square
+	*/
+	bool centered(const uint32_t n) {
+		const uint32_t e = empty(nodes[n].level-2);
+		for(uint i=0;i<4;i++){
+			for(uint j=0;j<4;j++){
+				if(j==3-i){continue;} //grandchild touching the center
+				if(child(child(n,i),j)!=e){ return 0; }
+			}
+		}
+		return 1;
+	}
+
+	/**
+	 * @brief Advance plane 2^step generations
+	*/
+	void advance(const uint step) {
+		//pattern must stay in nextGen result, it spreads at most 1 cell per generation
+		while(nodes[root].level < step+3 || !centered(root)){
+			root = expand(root);
+		}
+		root = nextGen(expand(root), step);
+	}
+
+	void forgetResults() {
+		for(Node &node : nodes){
+			node.resultStep = noStep;
+		}
+	}
+
+	/**
+	 * @brief Drop nodes unreachable from root
+	*/
+	void collect() {
+		std::vector<Node> oldNodes;
+		oldNodes.swap(nodes);
+		const uint32_t oldRoot = root;
+		const bool oldViewDirty = viewDirty;
+		reset();
+		std::unordered_map<uint32_t, uint32_t> moved;
+		root = copyNode(oldNodes, moved, oldRoot);
+		viewDirty = oldViewDirty;
+	}
+
+	uint32_t copyNode(const std::vector<Node> &oldNodes, std::unordered_map<uint32_t, uint32_t> &moved, const uint32_t n) {
+		if(oldNodes[n].level==0){ return n; }
+		auto it = moved.find(n);
+		if(it!=moved.end()){ return it->second; }
+		uint32_t c[4];
+		for(uint i=0;i<4;i++){
+			c[i] = copyNode(oldNodes, moved, oldNodes[n].child[i]);
+		}
+		uint32_t newInd = join(c[0], c[1], c[2], c[3]);
+		moved.emplace(n, newInd);
+		return newInd;
+	}
+
+	/**
+	 * @brief Viewport origin in plane coordinates
+	*/
+	inline int64_t viewX(const CAGrid<uint8_t> &grid) const { return -(int64_t)grid.getRows()/2; }
+	inline int64_t viewY(const CAGrid<uint8_t> &grid) const { return -(int64_t)grid.getCols()/2; }
+
+	/**
+	 * @brief Replace viewport area of the plane with grid
+	*/
+	void importView(const CAGrid<uint8_t> &grid) {
+		const int64_t viewSize = std::max(grid.getRows(), grid.getCols());
+		while( ((int64_t)1 << (nodes[root].level-1)) < viewSize ){
+			root = expand(root);
+		}
+		const int64_t half = (int64_t)1 << (nodes[root].level-1);
+		root = importNode(grid, root, -half, -half);
+	}
+
+	uint32_t importNode(const CAGrid<uint8_t> &grid, const uint32_t n, const int64_t x0, const int64_t y0) {
+		const uint level = nodes[n].level;
+		const int64_t size = (int64_t)1 << level;
+		const int64_t vx = viewX(grid);
+		const int64_t vy = viewY(grid);
+		if( x0>=vx+(int64_t)grid.getRows() || x0+size<=vx || y0>=vy+(int64_t)grid.getCols() || y0+size<=vy ){
+			return n; //outside viewport
+		}
+		if(level==0){
+			return grid[x0-vx][y0-vy];
+		}
+		const int64_t half = size/2;
+		uint32_t c[4];
+		for(uint i=0;i<4;i++){
+			c[i] = importNode(grid, child(n,i), x0+(i>>1)*half, y0+(i&1)*half);
+		}
+		return join(c[0], c[1], c[2], c[3]);
+	}
+
+	/**
+	 * @brief Write viewport of the plane to both grids and refresh their halo
+	*/
+	void exportView(CAGrid<uint8_t> (&grids)[2]) {
+		grids[0].clear();
+		const int64_t half = (int64_t)1 << (nodes[root].level-1);
+		exportNode(grids[0], root, -half, -half);
+		for(size_t x=0;x<grids[0].getRows();x++){
+			std::memcpy(grids[1][x], grids[0][x], grids[0].getCols());
+			grids[0].refreshRowHalo(x);
+			grids[1].refreshRowHalo(x);
+		}
+	}
+
+	void exportNode(CAGrid<uint8_t> &grid, const uint32_t n, const int64_t x0, const int64_t y0) {
+		const uint level = nodes[n].level;
+		const int64_t size = (int64_t)1 << level;
+		const int64_t vx = viewX(grid);
+		const int64_t vy = viewY(grid);
+		if( x0>=vx+(int64_t)grid.getRows() || x0+size<=vx || y0>=vy+(int64_t)grid.getCols() || y0+size<=vy ){
+			return;
+		}
+		if(n==empty(level)){ return; } //grid is cleared
+		if(level==0){
+			grid[x0-vx][y0-vy] = n;
+			return;
+		}
+		const int64_t half = size/2;
+		for(uint i=0;i<4;i++){
+			exportNode(grid, child(n,i), x0+(i>>1)*half, y0+(i&1)*half);
+		}
+	}
+};
@@ -0,0 +1,226 @@
+/**
+ * @file kaelifeCAJit.hpp
+ *
+ * @brief CAData presets compiled to shared objects at runtime
+*/
+
+#pragma once
+
+#include "kaelRandom.hpp"
+#include "kaelifeCACache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__)
+	#include <dlfcn.h>
+	#include <unistd.h>
+	#define KAELIFE_JIT 1
+#else
+	#define KAELIFE_JIT 0
+#endif
+
+/**
+ * @brief Compile the loaded preset to a row kernel with the system compiler and dlopen it
+ *
+ * Mask taps, weights, clip, rule ranges and state count are written into the source as constants,
+ * so the compiler drops zero taps, folds weights and can vectorize the whole row.
+ * Shared objects are cached by source and host CPU hash in $KAELIFE_JIT_DIR, $XDG_CACHE_HOME/kaelife or ~/.cache/kaelife,
+ * so a preset is compiled once per machine, and a cache shared between machines never loads code built for another ISA.
+ * Compiler is $KAELIFE_JIT_CXX or c++
+ *
+ * Any failure returns nullptr and CAKernel falls back to the interpreted kernels
+*/
+class CAJit {
+public:
+	CAJit() {}
+	CAJit(const CAJit&) = delete;
+	CAJit& operator=(const CAJit&) = delete;
+
+	/**
+	 * @brief Loaded kernels stay valid until destruction, threads may still hold old pointers
+	*/
+	~CAJit() {
+		#if KAELIFE_JIT
+			for(auto &entry : handles){
+				dlclose(entry.second);
+			}
+		#endif
+	}
+
+	/**
+	 * @brief Compiled row kernel of preset in cache, compiled now if not in the cache directory. Not thread safe
+	 *
+	 * @param cache mainCache with loaded mask and rules
+	 * @return nullptr if compiling or loading failed
+	*/
+	CACache::JitRowKernel compile(const CACache::ThreadCache &cache) {
+		#if KAELIFE_JIT
+			const std::string source = generateSource(cache);
+			const std::string compiler = getenv("KAELIFE_JIT_CXX") ? getenv("KAELIFE_JIT_CXX") : "c++";
+			const std::string flags = "-std=c++17 -O3 -march=native -shared -fPIC";
+			const uint64_t hash = kaelife::rand.hashCstr(compiler+flags+cpuIdentity()+source); //-march=native objects only run on the same CPU
+			char name[32];
+			snprintf(name, sizeof(name), "kaelifeJit_%016lx", hash);
+
+			auto loaded = handles.find(hash);
+			if(loaded!=handles.end()){
+				return (CACache::JitRowKernel)dlsym(loaded->second, "kaelifeJitRow");
+			}
+
+			std::error_code error;
+			const std::filesystem::path dir = cacheDir();
+			std::filesystem::create_directories(dir, error);
+			const std::filesystem::path lib = dir / (std::string(name)+".so");
+			if(!std::filesystem::exists(lib)){
+				const std::filesystem::path src = dir / (std::string(name)+".cpp");
+				const std::filesystem::path log = dir / (std::string(name)+".log");
+				const std::filesystem::path tmp = dir / (std::string(name)+"."+std::to_string(getpid())+".so"); //other processes may compile the same preset
+				std::ofstream srcFile(src);
+				srcFile << source;
+				srcFile.close();
+				if(!srcFile.good()){
+					printf("JIT couldn't write %s\n", src.c_str());
+					return nullptr;
+				}
+
+				const std::string command = compiler+" "+flags+" -o \""+tmp.string()+"\" \""+src.string()+"\" >\""+log.string()+"\" 2>&1";
+				printf("JIT compiling %s\n", src.c_str());
+				if(std::system(command.c_str())!=0){
+					printf("JIT compile failed, see %s\n", log.c_str());
+					std::filesystem::remove(tmp, error);
+					return nullptr;
+				}
+				std::filesystem::rename(tmp, lib, error);
+				if(error){
+					printf("JIT couldn't write %s\n", lib.c_str());
+					return nullptr;
+				}
+			}
+
+			void* handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+			if(handle==nullptr){
+				printf("JIT dlopen failed: %s\n", dlerror());
+				return nullptr;
+			}
+			void* symbol = dlsym(handle, "kaelifeJitRow");
+			if(symbol==nullptr){
+				printf("JIT kaelifeJitRow not found in %s\n", lib.c_str());
+				dlclose(handle);
+				return nullptr;
+			}
+			handles.emplace(hash, handle);
+			return (CACache::JitRowKernel)symbol;
+		#else
+			(void)cache;
+			return nullptr;
+		#endif
+	}
+
+	/**
+	 * @brief C++ source of a row kernel with every preset value as a constant
+	 *
+	 * Same arithmetic as CAKernel::iterateCell, rules are applied like CAKernel::compileRules builds ruleNext
+	*/
+	static std::string generateSource(const CACache::ThreadCache &cache) {
+		std::ostringstream src;
+		src << "//Generated by CAJit, safe to delete\n";
+		src << "#include <cstddef>\n";
+		src << "typedef unsigned short u16;\n";
+		src << "typedef " << (cache.maskTaps.size()*UINT8_MAX <= UINT16_MAX ? "u16" : "unsigned") << " sum_t;\n"; //16-bit sums vectorize twice as wide
+		src << "static inline u16 weigh(u16 product){ return (u16)(((unsigned)product*0x8081u)>>16)>>7; } //product/255, vectorizes as 16-bit multiply high\n";
+		src << "static inline u16 clip(u16 cell){ return cell>=" << (uint)cache.clipTreshold << " ? cell : 0; } //select on a loaded value, a ternary on loads isn't if-converted\n";
+		src << "extern \"C\" bool kaelifeJitRow(const unsigned char* readBuf, unsigned char* writeBuf, std::ptrdiff_t stride, unsigned tx, unsigned y0, unsigned y1) {\n";
+		src << "\tconst unsigned char* row = readBuf + tx*stride;\n";
+		src << "\tunsigned char* dst = writeBuf + tx*stride;\n";
+		src << "\tunsigned char changed = 0;\n";
+		src << "\tfor(unsigned y=y0;y<y1;++y){\n";
+		src << "\t\tconst unsigned char* c = row + y;\n";
+		src << "\t\tsum_t s = 0;\n";
+		for(uint i=0;i<cache.maskElements;++i){
+			const uint weight = cache.neigMask1d[i];
+			if(weight==0){continue;}
+			const int x = i%cache.maskWidth-cache.maskRadx;
+			const int y = i/cache.maskWidth-cache.maskRady;
+			std::string cell = "c["+std::to_string(x)+"*stride"+(y<0 ? "" : "+")+std::to_string(y)+"]";
+			if(cache.clipTreshold>0){
+				cell = "clip("+cell+")";
+			}
+			if(weight==UINT8_MAX){
+				src << "\t\ts += " << cell << ";\n";
+			}else{
+				src << "\t\ts += weigh(" << cell << "*" << weight << ");\n";
+			}
+		}
+
+		//first range that neigsum is below wins, so ranges are applied from the last
+		//as masked blends, a long ternary chain turns into branches and stops vectorization
+		const size_t rangeCount = cache.ruleRange.size();
+		auto addOf = [&](size_t i) -> int {
+			if(cache.ruleAdd.empty()){ return 0; }
+			return i<cache.ruleAdd.size() ? cache.ruleAdd[i] : cache.ruleAdd.back();
+		};
+		src << "\t\tshort add = " << (cache.ruleAdd.empty() ? 0 : (int)cache.ruleAdd.back()) << ";\n";
+		for(size_t i=rangeCount;i-->0;){
+			src << "\t\tadd ^= (add ^ (" << addOf(i) << ")) & -(short)(s<" << cache.ruleRange[i] << ");\n";
+		}
+		src << "\t\tshort next = c[0] + add;\n";
+		src << "\t\tnext = next<0 ? 0 : next>" << cache.stateCount-1 << " ? " << cache.stateCount-1 << " : next;\n";
+		src << "\t\tchanged |= (unsigned char)next ^ c[0];\n";
+		src << "\t\tdst[y] = (unsigned char)next;\n";
+		src << "\t}\n";
+		src << "\treturn changed;\n";
+		src << "}\n";
+		return src.str();
+	}
+
+private:
+	#if KAELIFE_JIT
+		std::unordered_map<uint64_t, void*> handles; //source hash to dlopen handle
+	#endif
+
+	/**
+	 * @brief Model and ISA features of the host CPU, what -march=native compiles for
+	*/
+	static const std::string& cpuIdentity() {
+		static const std::string identity = [](){
+			std::string id;
+			std::ifstream cpuinfo("/proc/cpuinfo");
+			std::string line;
+			while(std::getline(cpuinfo, line) && !line.empty()){ //first processor is enough
+				if(line.starts_with("model name") || line.starts_with("flags") || line.starts_with("Features") || line.starts_with("CPU part")){
+					id += line + "\n";
+				}
+			}
+			#if defined(__x86_64__) || defined(__i386__)
+				if(id.empty()){ //no procfs
+					__builtin_cpu_init();
+					const bool features[] = { //__builtin_cpu_supports only takes literals
+						(bool)__builtin_cpu_supports("sse4.2"), (bool)__builtin_cpu_supports("avx"), (bool)__builtin_cpu_supports("avx2"),
+						(bool)__builtin_cpu_supports("fma"), (bool)__builtin_cpu_supports("bmi2"), (bool)__builtin_cpu_supports("avx512f"),
+						(bool)__builtin_cpu_supports("avx512bw"), (bool)__builtin_cpu_supports("avx512vl")
+					};
+					for(bool feature : features){
+						id += feature ? '1' : '0';
+					}
+				}
+			#endif
+			return id;
+		}();
+		return identity;
+	}
+
+	static std::filesystem::path cacheDir() {
+		if(getenv("KAELIFE_JIT_DIR")){ return getenv("KAELIFE_JIT_DIR"); }
+		if(getenv("XDG_CACHE_HOME")){ return std::filesystem::path(getenv("XDG_CACHE_HOME")) / "kaelife"; }
+		if(getenv("HOME")){ return std::filesystem::path(getenv("HOME")) / ".cache" / "kaelife"; }
+		return std::filesystem::temp_directory_path() / "kaelife";
+	}
+};
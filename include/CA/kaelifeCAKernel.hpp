@@ -0,0 +1,741 @@
+/**
+ * @file kaelifeCAKernel.hpp
+ *
+ * @brief CAData cell iteration kernels
+ *
+ * Every kernel writes one full row segment of the next generation from cellState[activeBuf] to cellState[!activeBuf]
+ * and returns whether any cell changed. All kernels give bit-identical results
+*/
+
+#pragma once
+
+#include "kaelifeCACache.hpp"
+#include "kaelifeCABitEngine.hpp"
+#include "kaelifeCAHashlife.hpp"
+
+#include <iostream>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define KAELIFE_X86_SIMD 1
+	#include <immintrin.h>
+#else
+	#define KAELIFE_X86_SIMD 0
+#endif
+
+/**
+ * @brief Cellular automata iteration kernels
+ *
+ * SIMD kernel processes cells along Y axis, 32 per instruction with AVX2 or 16 with SSE2.
+ * Instruction set is chosen once at runtime. Row tails that don't fill a vector use the scalar kernel
+ *
+ * Box kernel sums masks that split to rectangles by rows and columns. Without SIMD it is the fastest kernel for such masks
+ *
+ * Fixed kernel is instantiated for mask sizes up to 9x9 and 2, 4 or 256 states. Tap count and offsets are compile time
+ * constants, so the tap loop is fully unrolled and the weights stay in registers. The instance is picked once in compileFixed
+ *
+ * 16-bit cells run only scalar and box kernels. Other kernels pack, table or generate code for 8-bit cells
+*/
+class CAKernel {
+public:
+	/**
+	 * @brief Selectable kernels. Stored in ThreadCache::kernel
+	*/
+	enum KernelType : uint8_t {
+		KERNEL_AUTO = 0, //pick fastest kernel for the preset
+		KERNEL_SCALAR,
+		KERNEL_SIMD,
+		KERNEL_TABLE, //scalar with weightTables
+		KERNEL_BOX, //separable row and column sums of boxLayers
+		KERNEL_FIXED, //unrolled instance for the mask size and state count, see compileFixed
+		KERNEL_JIT, //CAJit preset compiled at runtime. Never picked by auto, compiling takes a while
+		KERNEL_BIT, //CABitEngine. Not a row kernel, CAData iterates packed stripes instead
+		KERNEL_HASHLIFE, //CAHashlife unbounded plane. Never picked by auto, world doesn't wrap
+		KERNEL_CHUNKED, //CAChunks unbounded plane of allocated chunks. Never picked by auto, world doesn't wrap
+		KERNEL_COUNT
+	};
+	static constexpr const char* kernelName[KERNEL_COUNT] = {"auto", "scalar", "simd", "table", "box", "fixed", "jit", "bit", "hashlife", "chunked"};
+
+	/**
+	 * @brief Runtime detected instruction set
+	*/
+	enum SimdLevel : uint8_t {
+		SIMD_NONE = 0,
+		SIMD_SSE2,
+		SIMD_AVX2
+	};
+	static constexpr const char* simdName[3] = {"none", "SSE2", "AVX2"};
+
+	/**
+	 * @brief Detect instruction set once
+	*/
+	static SimdLevel simdLevel() {
+		static const SimdLevel level = detectSimd();
+		return level;
+	}
+
+	/**
+	 * @brief Resolve KERNEL_AUTO and unavailable kernels to a kernel that can run the preset
+	 *
+	 * @param preferred user preference
+	 * @param cache loaded mainCache
+	*/
+	static KernelType resolveKernel(KernelType preferred, const CACache::ThreadCache &cache) {
+		bool simdFits = simdLevel()!=SIMD_NONE && cache.maskTaps.size()*UINT8_MAX <= INT16_MAX; //16-bit lanes can't overflow
+		bool boxFits = !cache.boxLayers.empty();
+		bool bitFits = CABitEngine::fits(cache);
+		if(preferred==KERNEL_SIMD && !simdFits){ preferred = KERNEL_AUTO; }
+		if(preferred==KERNEL_BOX  && !boxFits ){ preferred = KERNEL_AUTO; }
+		if(preferred==KERNEL_FIXED && cache.fixedRow==nullptr){ preferred = KERNEL_AUTO; }
+		if(preferred==KERNEL_JIT && cache.jitRow==nullptr){ preferred = KERNEL_AUTO; } //compiler unavailable or failed
+		if(preferred==KERNEL_BIT  && !bitFits ){ preferred = KERNEL_AUTO; }
+		if(preferred==KERNEL_HASHLIFE && !CAHashlife::fits(cache)){ preferred = KERNEL_AUTO; }
+		if(preferred==KERNEL_AUTO){
+			if(bitFits){ return KERNEL_BIT; }
+			return resolveRowKernel(cache);
+		}
+		return preferred;
+	}
+
+	/**
+	 * @brief resolveKernel of 16-bit cells. Every other preference resolves like KERNEL_AUTO
+	*/
+	static KernelType resolveKernel(KernelType preferred, const CACache::ThreadCacheT<uint16_t> &cache) {
+		bool boxFits = !cache.boxLayers.empty();
+		if(preferred==KERNEL_SCALAR){ return KERNEL_SCALAR; }
+		if(preferred==KERNEL_BOX && boxFits){ return KERNEL_BOX; }
+		if(boxFits && boxCost(cache) <= cache.maskTaps.size()){ return KERNEL_BOX; } //scalar taps don't vectorize either
+		return KERNEL_SCALAR;
+	}
+
+	/**
+	 * @brief Fastest kernel that iterateRow can run for the preset. Measured with tools/caKernelBench.cpp
+	 *
+	 * @param cache loaded cache. Box layers must be compiled for its tileStride
+	*/
+	static KernelType resolveRowKernel(const CACache::ThreadCache &cache) {
+		if(simdLevel()!=SIMD_NONE && cache.maskTaps.size()*UINT8_MAX <= INT16_MAX){ return KERNEL_SIMD; }
+		if(cache.fixedRow!=nullptr && cache.stateCount<=2){ return KERNEL_FIXED; } //8-bit sums without weighting
+		if(!cache.boxLayers.empty() && boxCost(cache) <= 2*cache.maskTaps.size()){ return KERNEL_BOX; } //box loops vectorize, table loads don't
+		return KERNEL_TABLE; //fixed is slower than table once cells are weighted, it stays selectable by hand
+	}
+
+	/**
+	 * @brief Build weightTables and link each maskTaps element to the table of its weight
+	 *
+	 * Table of weight w holds v*w/255 for every cell value v, or 0 if v is below clipTreshold
+	 *
+	 * @param cache mainCache with loaded maskTaps and clipTreshold
+	*/
+	static void compileWeights(CACache::ThreadCache &cache) {
+		const size_t rowSize = UINT8_MAX+1;
+		int tableOfWeight[UINT8_MAX+1];
+		std::fill(tableOfWeight, tableOfWeight+UINT8_MAX+1, -1);
+
+		cache.weightTables.clear();
+		for(CACache::MaskTap &tap : cache.maskTaps){
+			if(tableOfWeight[tap.weight]<0){ //taps with equal weight share a table
+				tableOfWeight[tap.weight] = cache.weightTables.size();
+				for(uint v=0;v<rowSize;++v){
+					cache.weightTables.push_back( v<cache.clipTreshold ? 0 : v*tap.weight/UINT8_MAX );
+				}
+			}
+			tap.table = tableOfWeight[tap.weight];
+		}
+	}
+
+	/**
+	 * @brief Split neigMask to BoxLayer rectangles, one per distinct weight
+	 *
+	 * A weight whose elements don't form a rectangle leaves boxLayers empty. 
+	 * A single rectangle may miss the mask center if the center weight is 0, like Conway
+	 *
+	 * @param cache mainCache with loaded neigMask1d and tileStride
+	*/
+	template<typename Cell>
+	static void compileBoxLayers(CACache::ThreadCacheT<Cell> &cache) {
+		cache.boxLayers.clear();
+		if(cache.maskElements==0){ return; }
+
+		const uint centerInd = cache.maskRadx + cache.maskRady*cache.maskWidth;
+		bool centerFree = cache.neigMask1d[centerInd]==0;
+		bool weightDone[UINT8_MAX+1] = {};
+		weightDone[0] = 1;
+
+		for(uint i=0;i<cache.maskElements;++i){
+			const uint8_t weight = cache.neigMask1d[i];
+			if(weightDone[weight]){continue;}
+			weightDone[weight] = 1;
+
+			std::vector<bool> rowUsed(cache.maskWidth, 0);
+			std::vector<bool> colUsed(cache.maskHeight, 0);
+			uint count=0;
+			for(uint j=i;j<cache.maskElements;++j){
+				if(cache.neigMask1d[j]!=weight){continue;}
+				rowUsed[j%cache.maskWidth] = 1;
+				colUsed[j/cache.maskWidth] = 1;
+				count++;
+			}
+
+			CACache::BoxLayer layer = {.weight = weight, .rowOffsets = {}, .cols = {}, .centerHole = 0};
+			for(int x=0;x<cache.maskWidth;++x){
+				if(rowUsed[x]){ layer.rowOffsets.push_back( (x-cache.maskRadx)*(int32_t)cache.tileStride ); }
+			}
+			for(int y=0;y<cache.maskHeight;++y){
+				if(colUsed[y]){ layer.cols.push_back( y-cache.maskRady ); }
+			}
+
+			const uint area = layer.rowOffsets.size()*layer.cols.size();
+			if(count!=area){
+				bool centerInside = rowUsed[cache.maskRadx] && colUsed[cache.maskRady];
+				if(!(centerFree && centerInside && count+1==area)){
+					cache.boxLayers.clear(); //not separable
+					return;
+				}
+				layer.centerHole = 1;
+				centerFree = 0;
+			}
+			cache.boxLayers.push_back(layer);
+		}
+	}
+
+	/**
+	 * @brief Zero pad neigMask to the nearest fixed kernel mask size and pick its instance for stateCount
+	 *
+	 * Masks that reach further than fixedMaxRad from their center leave fixedRow nullptr
+	 *
+	 * @param cache mainCache with loaded neigMask1d and stateCount
+	*/
+	static void compileFixed(CACache::ThreadCache &cache) {
+		cache.fixedWeights.clear();
+		cache.fixedRow = nullptr;
+		const uint radX = std::max<uint>(std::max<int>(cache.maskRadx, cache.maskWidth-1-cache.maskRadx), 1);
+		const uint radY = std::max<uint>(std::max<int>(cache.maskRady, cache.maskHeight-1-cache.maskRady), 1);
+		if(cache.maskElements==0 || radX>fixedMaxRad || radY>fixedMaxRad){ return; }
+
+		const uint width = 2*radX+1;
+		const uint height = 2*radY+1;
+		cache.fixedWeights.resize(width*height, 0);
+		for(uint i=0;i<cache.maskElements;++i){
+			const uint x = i%cache.maskWidth-cache.maskRadx+radX;
+			const uint y = i/cache.maskWidth-cache.maskRady+radY;
+			cache.fixedWeights[x*height+y] = cache.neigMask1d[i];
+		}
+		const uint stateClass = cache.stateCount<=2 ? 0 : cache.stateCount<=4 ? 1 : 2;
+		static const auto table = fixedTable(std::make_index_sequence<fixedMaxRad*fixedMaxRad*3>{});
+		cache.fixedRow = table[((radX-1)*fixedMaxRad + radY-1)*3 + stateClass];
+	}
+
+	/**
+	 * @brief Per cell work of box kernel, rows and columns summed for each layer
+	*/
+	template<typename Cell>
+	static uint boxCost(const CACache::ThreadCacheT<Cell> &cache) {
+		uint cost = 0;
+		for(const CACache::BoxLayer &layer : cache.boxLayers){
+			cost += layer.rowOffsets.size() + layer.cols.size() + layer.centerHole;
+		}
+		return cost;
+	}
+
+	/**
+	 * @brief Build rule lookup tables from ruleRange, ruleAdd, stateCount and maskTaps
+	 *
+	 * Neighbor sum can't exceed sum of tap weights, so every reachable sum gets a ruleNext row offset.
+	 * Each ruleNext row holds the clamped next state for every possible uint8_t cell value
+	 *
+	 * @param cache mainCache with loaded rules and maskTaps
+	*/
+	static void compileRules(CACache::ThreadCache &cache) {
+		uint maxNeigsum = 0;
+		for(const CACache::MaskTap &tap : cache.maskTaps){
+			maxNeigsum += tap.weight; //cell*weight/255 <= weight
+		}
+
+		const size_t rangeCount = cache.ruleRange.size();
+		const size_t rowSize = UINT8_MAX+1;
+		cache.ruleNext.resize((rangeCount+1)*rowSize);
+		for(size_t i=0;i<=rangeCount;++i){
+			int addValue = 0;
+			if(!cache.ruleAdd.empty()){ //last row is used if neigsum is past every range
+				addValue = i<rangeCount ? cache.ruleAdd[i] : cache.ruleAdd.back();
+			}
+			for(size_t state=0;state<rowSize;++state){
+				cache.ruleNext[i*rowSize+state] = std::clamp((int)state+addValue, 0, (int)cache.stateCount-1);
+			}
+		}
+
+		cache.ruleOffset.resize(maxNeigsum+1);
+		for(uint neigsum=0;neigsum<=maxNeigsum;++neigsum){
+			size_t rangeInd = rangeCount;
+			for(size_t i=0;i<rangeCount;i++){ //same linear search that the table replaces
+				if((int)neigsum<cache.ruleRange[i]){
+					rangeInd=i;
+					break;
+				}
+			}
+			cache.ruleOffset[neigsum] = rangeInd*rowSize;
+		}
+	}
+
+	/**
+	 * @brief compileRules of 16-bit cells. ruleNext rows of every cell value wouldn't fit cache
+	 *
+	 * ruleOffset maps neigsum to a range index, and the cell is clamped after adding rangeAdd of the range.
+	 * Table covers sums that cells below stateCount reach, at most ruleTableSize of them. Bigger sums search ruleRange
+	 *
+	 * @param cache mainCache with loaded rules and maskTaps
+	*/
+	static void compileRules(CACache::ThreadCacheT<uint16_t> &cache) {
+		uint64_t maxNeigsum = 0;
+		for(const CACache::MaskTap &tap : cache.maskTaps){
+			maxNeigsum += (uint64_t)(cache.stateCount-1)*tap.weight/UINT8_MAX;
+		}
+
+		const size_t rangeCount = cache.ruleRange.size();
+		cache.rangeAdd.resize(rangeCount+1);
+		for(size_t i=0;i<=rangeCount;++i){
+			int32_t addValue = 0;
+			if(!cache.ruleAdd.empty()){
+				addValue = i<rangeCount ? cache.ruleAdd[i] : cache.ruleAdd.back();
+			}
+			cache.rangeAdd[i] = addValue;
+		}
+
+		cache.ruleOffset.resize(std::min<uint64_t>(maxNeigsum+1, ruleTableSize));
+		for(uint neigsum=0;neigsum<cache.ruleOffset.size();++neigsum){
+			cache.ruleOffset[neigsum] = rangeIndex(cache, neigsum);
+		}
+		cache.ruleNext.clear();
+	}
+
+	/**
+	 * @brief Iterate cells [y0,y1) of row tx with lv.kernel
+	 *
+	 * @param lv thread cache
+	 * @param readBuf cellState[lv.activeBuf].data()
+	 * @param writeBuf cellState[!lv.activeBuf].data()
+	 * @return true if any cell differs from readBuf
+	*/
+	static inline bool iterateRow(CACache::ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint tx, uint y0, const uint y1) {
+		if(lv.kernel==KERNEL_BOX){
+			return boxRow(lv, readBuf, writeBuf, tx, y0, y1);
+		}
+		if(lv.kernel==KERNEL_FIXED){
+			return lv.fixedRow(lv, readBuf, writeBuf, tx, y0, y1);
+		}
+		if(lv.kernel==KERNEL_JIT){
+			return lv.jitRow(readBuf, writeBuf, lv.tileStride, tx, y0, y1);
+		}
+		bool changed = 0;
+		#if KAELIFE_X86_SIMD
+		if(lv.kernel==KERNEL_SIMD){
+			if(simdLevel()==SIMD_AVX2){
+				y0 = avx2Row(lv, readBuf, writeBuf, tx, y0, y1, changed);
+			}else{
+				y0 = sse2Row(lv, readBuf, writeBuf, tx, y0, y1, changed);
+			}
+		}
+		#endif
+		if(lv.kernel==KERNEL_TABLE || lv.kernel==KERNEL_BIT){ //bit engine uses table kernel for tasks it can't pack
+			for (uint ty = y0; ty < y1; ++ty) {
+				changed |= iterateCellTable(lv, readBuf, writeBuf, tx, ty);
+			}
+			return changed;
+		}
+		for (uint ty = y0; ty < y1; ++ty) {
+			changed |= iterateCell(lv, readBuf, writeBuf, tx, ty);
+		}
+		return changed;
+	}
+
+	/**
+	 * @brief iterateRow of 16-bit cells
+	*/
+	static inline bool iterateRow(CACache::ThreadCacheT<uint16_t> &lv, const uint16_t* readBuf, uint16_t* writeBuf, const uint tx, const uint y0, const uint y1) {
+		if(lv.kernel==KERNEL_BOX){
+			return boxRow(lv, readBuf, writeBuf, tx, y0, y1);
+		}
+		bool changed = 0;
+		for (uint ty = y0; ty < y1; ++ty) {
+			changed |= iterateCell(lv, readBuf, writeBuf, tx, ty);
+		}
+		return changed;
+	}
+
+	//Cellular automata iteration logic using ThreadCache lv
+	/**
+	 * @brief Iterate single cellState[Active Buf][ti][tj]
+	 *
+	 * Neighbors past the world border are read from cellState halo, so no coordinate is wrapped here
+	 *
+	 * @param ti Row
+	 * @param tj Column
+	 * @param readBuf cellState[lv.activeBuf].data()
+	 * @param writeBuf cellState[!lv.activeBuf].data()
+	 * @return true if the cell changed
+	*/
+	template<typename Cell>
+	static inline bool iterateCell(CACache::ThreadCacheT<Cell> &lv, const Cell* readBuf, Cell* writeBuf, const uint ti, const uint tj){
+
+		uint neigsum=0;
+		const size_t cellInd = ti*lv.tileStride + tj;
+		const Cell* cellPtr = readBuf + cellInd;
+		const Cell currentCellState = *cellPtr; //current cell value
+
+		if(kaelife::CA_DEBUG){
+			if(ti>=lv.tileRows || tj>=lv.tileCols){
+				printf("OUT OF WORLD BOUNDS iterateCell\n");
+				abort();
+			}
+		}
+
+		for(const CACache::MaskTap &tap : lv.maskTaps){
+			uint neigValue=cellPtr[tap.offset]; //get world or halo cell value
+
+			if(neigValue < lv.clipTreshold){continue;} //clip any values below clipTreshold
+
+			neigValue=neigValue*tap.weight/UINT8_MAX; //weight
+			neigsum+=neigValue;
+		}
+
+		//range search, add and clamp are precomputed in compileRules
+		const Cell newCellState = nextState(lv, neigsum, currentCellState);
+		writeBuf[cellInd] = newCellState; //write to inactive buffer
+		return newCellState != currentCellState;
+	}
+
+	/**
+	 * @brief iterateCell using weightTables. Clip and weighting are a single table load per tap
+	*/
+	static inline bool iterateCellTable(CACache::ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint ti, const uint tj){
+		uint neigsum=0;
+		const size_t cellInd = ti*lv.tileStride + tj;
+		const uint8_t* cellPtr = readBuf + cellInd;
+		const uint8_t* tables = lv.weightTables.data();
+
+		for(const CACache::MaskTap &tap : lv.maskTaps){
+			neigsum+=tables[tap.table + cellPtr[tap.offset]];
+		}
+
+		const uint8_t currentCellState = *cellPtr;
+		const uint8_t newCellState = lv.ruleNext[lv.ruleOffset[neigsum] + currentCellState];
+		writeBuf[cellInd] = newCellState;
+		return newCellState != currentCellState;
+	}
+
+private:
+	static constexpr const size_t ruleTableSize = 1<<16; //largest 16-bit cell ruleOffset, 128 KiB
+
+	/**
+	 * @brief cell*weight/255 or 0 if below clip. Exact for every uint8_t cell and weight
+	*/
+	static inline uint32_t weightCell(const uint32_t cell, const uint32_t weight, const uint32_t clip) {
+		return cell<clip ? 0 : (cell*weight*0x8081u)>>23;
+	}
+
+	/**
+	 * @brief weightCell of any cell type. 16-bit cell*weight exceeds the range where the multiply shift is exact
+	*/
+	template<typename Cell>
+	static inline uint32_t weightCellOf(const Cell cell, const uint32_t weight, const uint32_t clip) {
+		if constexpr(sizeof(Cell)==1){
+			return weightCell(cell, weight, clip);
+		}
+		return cell<clip ? 0 : cell*weight/UINT8_MAX;
+	}
+
+	/**
+	 * @brief Next clamped state of 8-bit cell from compileRules tables
+	*/
+	static inline uint8_t nextState(const CACache::ThreadCache &lv, const uint neigsum, const uint8_t cell) {
+		return lv.ruleNext[lv.ruleOffset[neigsum] + cell];
+	}
+
+	/**
+	 * @brief Next clamped state of 16-bit cell. Sums past the table are searched, only cells above stateCount reach them
+	*/
+	static inline uint16_t nextState(const CACache::ThreadCacheT<uint16_t> &lv, const uint neigsum, const uint16_t cell) {
+		const uint rangeInd = neigsum<lv.ruleOffset.size() ? lv.ruleOffset[neigsum] : rangeIndex(lv, neigsum);
+		return std::clamp<int32_t>(cell+lv.rangeAdd[rangeInd], 0, lv.stateCount-1);
+	}
+
+	/**
+	 * @brief Index of first ruleRange that neigsum is below, or range count if none
+	*/
+	template<typename Cell>
+	static uint rangeIndex(const CACache::ThreadCacheT<Cell> &lv, const uint neigsum) {
+		const size_t rangeCount = lv.ruleRange.size();
+		for(size_t i=0;i<rangeCount;i++){
+			if((int64_t)neigsum<lv.ruleRange[i]){ return i; }
+		}
+		return rangeCount;
+	}
+
+	/**
+	 * @brief Box kernel. Sum every BoxLayer row first and then its columns
+	 *
+	 * Layer rows are summed to colSum over the row segment widened by the layer columns, 
+	 * then colSum is summed once per layer column. Cost per cell is rows+cols instead of rows*cols
+	 * Loops run over Y so the compiler can vectorize them
+	 * 
+	 * @note lv.boxScratch has to hold 2*(y1-y0)+maskHeight sums, see CACache::copyCache
+	*/
+	template<typename Cell>
+	static bool boxRow(CACache::ThreadCacheT<Cell> &lv, const Cell* readBuf, Cell* writeBuf, const uint tx, const uint y0, const uint y1) {
+		typedef typename CACellTraits<Cell>::Sum Sum;
+		const uint n = y1-y0;
+		Sum* sum = lv.boxScratch.data();
+		Sum* colSum = sum + n;
+		std::fill(sum, sum+n, 0);
+
+		const Cell* rowPtr = readBuf + tx*lv.tileStride + y0;
+		const uint32_t clip = lv.clipTreshold;
+		for(const CACache::BoxLayer &layer : lv.boxLayers){
+			const int firstCol = layer.cols.front();
+			const uint span = n + layer.cols.back()-firstCol;
+			const uint32_t weight = layer.weight;
+			std::fill(colSum, colSum+span, 0);
+
+			for(const int32_t rowOffset : layer.rowOffsets){
+				const Cell* src = rowPtr + rowOffset + firstCol;
+				for(uint i=0;i<span;++i){
+					colSum[i] += weightCellOf(src[i], weight, clip);
+				}
+			}
+			for(const int16_t col : layer.cols){
+				const Sum* src = colSum + (col-firstCol);
+				for(uint i=0;i<n;++i){
+					sum[i] += src[i];
+				}
+			}
+			if(layer.centerHole){
+				for(uint i=0;i<n;++i){
+					sum[i] -= weightCellOf(rowPtr[i], weight, clip);
+				}
+			}
+		}
+
+		Cell* dstPtr = writeBuf + tx*lv.tileStride + y0;
+		Cell changed = 0;
+		for(uint i=0;i<n;++i){
+			const Cell currentCellState = rowPtr[i];
+			const Cell newCellState = nextState(lv, sum[i], currentCellState);
+			changed |= newCellState ^ currentCellState;
+			dstPtr[i] = newCellState;
+		}
+		return changed;
+	}
+
+	static constexpr const uint fixedMaxRad = 4; //9x9 fits every mask of CAPreset::randRuleMask
+	static constexpr const uint fixedBlock = 64; //cells summed before rules are applied
+	static constexpr const uint fixedStates[3] = {2, 4, 256};
+
+	/**
+	 * @brief Every fixedRow instance. Index is ((radX-1)*fixedMaxRad + radY-1)*3 + state class
+	*/
+	template<size_t... I>
+	static constexpr std::array<CACache::RowKernel, sizeof...(I)> fixedTable(std::index_sequence<I...>) {
+		return {&fixedRow<I/3/fixedMaxRad+1, I/3%fixedMaxRad+1, fixedStates[I%3]>...};
+	}
+
+	/**
+	 * @brief Add weighted tap T of the (2*RX+1)*(2*RY+1) mask to sums of n cells starting at cellPtr
+	*/
+	template<uint T, uint RX, uint RY, uint States, typename Sum>
+	static inline void fixedTap(const uint8_t* cellPtr, const ptrdiff_t stride, const uint32_t weight, const uint32_t clip, Sum* sum, const uint n, uint8_t &maxCell) {
+		constexpr int x = (int)(T/(2*RY+1)) - (int)RX;
+		constexpr int y = (int)(T%(2*RY+1)) - (int)RY;
+		const uint8_t* src = cellPtr + x*stride + y;
+		for(uint i=0;i<n;++i){
+			const uint8_t v = src[i];
+			if constexpr(States==2){
+				sum[i] += v & weight; //weight is cell value 1 weighted, 0 or 1
+			}else{
+				const uint16_t product = v<clip ? 0 : v*weight;
+				sum[i] += (uint16_t)(((uint32_t)product*0x8081u)>>16)>>7; //16-bit lanes, same as weightCell
+			}
+			if constexpr(States<256){
+				maxCell = std::max(maxCell, v);
+			}
+		}
+	}
+
+	/**
+	 * @brief Fixed kernel. Sums blocks of fixedBlock cells tap by tap, then applies rules
+	 *
+	 * Cells of 2 and 4 state presets can't overflow 8-bit sums, so twice as many sums fit a vector.
+	 * A block that reads a cell past the state count, like after a preset change, is redone with the 256 state instance
+	 *
+	 * @tparam RX mask reach in X
+	 * @tparam RY mask reach in Y
+	 * @tparam States 2, 4 or 256. Highest expected state count
+	*/
+	template<uint RX, uint RY, uint States>
+	static bool fixedRow(CACache::ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint tx, const uint y0, const uint y1) {
+		constexpr uint taps = (2*RX+1)*(2*RY+1);
+		using Sum = std::conditional_t<States<=4, uint8_t, uint16_t>; //3*81 fits uint8_t
+		const uint32_t clip = lv.clipTreshold;
+		uint32_t weight[taps];
+		for(uint t=0;t<taps;++t){
+			weight[t] = States==2 ? weightCell(1, lv.fixedWeights[t], clip) : lv.fixedWeights[t];
+		}
+
+		const ptrdiff_t stride = lv.tileStride;
+		const uint8_t* rowPtr = readBuf + tx*stride;
+		uint8_t* dstPtr = writeBuf + tx*stride;
+		uint8_t changed = 0;
+		for(uint y=y0;y<y1;y+=fixedBlock){
+			const uint n = std::min(fixedBlock, y1-y);
+			Sum sum[fixedBlock] = {};
+			uint8_t maxCell = 0;
+			[&]<size_t... T>(std::index_sequence<T...>) {
+				(fixedTap<T, RX, RY, States>(rowPtr+y, stride, weight[T], clip, sum, n, maxCell), ...);
+			}(std::make_index_sequence<taps>{});
+
+			if constexpr(States<256){
+				if(maxCell>=States){
+					changed |= fixedRow<RX, RY, 256>(lv, readBuf, writeBuf, tx, y, y+n);
+					continue;
+				}
+			}
+			for(uint i=0;i<n;++i){
+				const uint8_t currentCellState = rowPtr[y+i];
+				const uint8_t newCellState = lv.ruleNext[lv.ruleOffset[sum[i]] + currentCellState];
+				changed |= newCellState ^ currentCellState;
+				dstPtr[y+i] = newCellState;
+			}
+		}
+		return changed;
+	}
+
+	static SimdLevel detectSimd() {
+		#if KAELIFE_X86_SIMD
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx2")){ return SIMD_AVX2; }
+			if(__builtin_cpu_supports("sse2")){ return SIMD_SSE2; }
+		#endif
+		return SIMD_NONE;
+	}
+
+#if KAELIFE_X86_SIMD
+	/*
+		Vectorized iterateCell. Per lane:
+		clip:	 v = v>=clipTreshold ? v : 0
+		weight:  v*w/255 == mulhi(v*w, 0x8081)>>7 for every v*w <= 255*255
+		rule:	 ruleRange scanned backwards so the first matching range wins like the linear search
+	*/
+
+	/**
+	 * @brief SSE2 kernel, 16 cells per step
+	 *
+	 * @param changed set if any iterated cell changed
+	 * @return first column that was not iterated
+	*/
+	static uint sse2Row(CACache::ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint tx, uint ty, const uint y1, bool &changed) {
+		const size_t rowInd = tx*lv.tileStride;
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i clip = _mm_set1_epi8((char)lv.clipTreshold);
+		const __m128i div255 = _mm_set1_epi16((short)0x8081);
+		const __m128i minState = _mm_setzero_si128();
+		const __m128i maxState = _mm_set1_epi16((short)(lv.stateCount-1));
+		const size_t rangeCount = lv.ruleRange.size();
+		__m128i changeAny = zero;
+
+		for(; ty+16<=y1; ty+=16){
+			const uint8_t* cellPtr = readBuf + rowInd + ty;
+			__m128i sumLo = zero;
+			__m128i sumHi = zero;
+			for(const CACache::MaskTap &tap : lv.maskTaps){
+				__m128i v = _mm_loadu_si128((const __m128i*)(cellPtr+tap.offset));
+				v = _mm_and_si128(v, _mm_cmpeq_epi8(_mm_max_epu8(v,clip), v)); //clip
+				const __m128i w = _mm_set1_epi16(tap.weight);
+				__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v,zero), w);
+				__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v,zero), w);
+				sumLo = _mm_add_epi16(sumLo, _mm_srli_epi16(_mm_mulhi_epu16(lo,div255),7));
+				sumHi = _mm_add_epi16(sumHi, _mm_srli_epi16(_mm_mulhi_epu16(hi,div255),7));
+			}
+
+			__m128i addLo = _mm_set1_epi16(lv.ruleAdd.back());
+			__m128i addHi = addLo;
+			for(size_t i=rangeCount;i-->0;){
+				const __m128i range = _mm_set1_epi16(lv.ruleRange[i]);
+				const __m128i add = _mm_set1_epi16(lv.ruleAdd[i]);
+				const __m128i inLo = _mm_cmpgt_epi16(range, sumLo);
+				const __m128i inHi = _mm_cmpgt_epi16(range, sumHi);
+				addLo = _mm_or_si128(_mm_and_si128(inLo,add), _mm_andnot_si128(inLo,addLo));
+				addHi = _mm_or_si128(_mm_and_si128(inHi,add), _mm_andnot_si128(inHi,addHi));
+			}
+
+			const __m128i oldState = _mm_loadu_si128((const __m128i*)cellPtr);
+			__m128i newLo = _mm_add_epi16(_mm_unpacklo_epi8(oldState,zero), addLo);
+			__m128i newHi = _mm_add_epi16(_mm_unpackhi_epi8(oldState,zero), addHi);
+			newLo = _mm_min_epi16(_mm_max_epi16(newLo,minState),maxState);
+			newHi = _mm_min_epi16(_mm_max_epi16(newHi,minState),maxState);
+			const __m128i newState = _mm_packus_epi16(newLo,newHi);
+
+			_mm_storeu_si128((__m128i*)(writeBuf + rowInd + ty), newState);
+			changeAny = _mm_or_si128(changeAny, _mm_xor_si128(newState,oldState));
+		}
+		changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(changeAny,zero))!=0xFFFF;
+		return ty;
+	}
+
+	/**
+	 * @brief AVX2 kernel, 32 cells per step
+	 *
+	 * @param changed set if any iterated cell changed
+	 * @return first column that was not iterated
+	*/
+	__attribute__((target("avx2")))
+	static uint avx2Row(CACache::ThreadCache &lv, const uint8_t* readBuf, uint8_t* writeBuf, const uint tx, uint ty, const uint y1, bool &changed) {
+		const size_t rowInd = tx*lv.tileStride;
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i clip = _mm256_set1_epi8((char)lv.clipTreshold);
+		const __m256i div255 = _mm256_set1_epi16((short)0x8081);
+		const __m256i maxState = _mm256_set1_epi16((short)(lv.stateCount-1));
+		const size_t rangeCount = lv.ruleRange.size();
+		__m256i changeAny = zero;
+
+		for(; ty+32<=y1; ty+=32){
+			const uint8_t* cellPtr = readBuf + rowInd + ty;
+			__m256i sumLo = zero;
+			__m256i sumHi = zero;
+			for(const CACache::MaskTap &tap : lv.maskTaps){
+				__m256i v = _mm256_loadu_si256((const __m256i*)(cellPtr+tap.offset));
+				v = _mm256_and_si256(v, _mm256_cmpeq_epi8(_mm256_max_epu8(v,clip), v)); //clip
+				const __m256i w = _mm256_set1_epi16(tap.weight);
+				__m256i lo = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)), w);
+				__m256i hi = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v,1)), w);
+				sumLo = _mm256_add_epi16(sumLo, _mm256_srli_epi16(_mm256_mulhi_epu16(lo,div255),7));
+				sumHi = _mm256_add_epi16(sumHi, _mm256_srli_epi16(_mm256_mulhi_epu16(hi,div255),7));
+			}
+
+			__m256i addLo = _mm256_set1_epi16(lv.ruleAdd.back());
+			__m256i addHi = addLo;
+			for(size_t i=rangeCount;i-->0;){
+				const __m256i range = _mm256_set1_epi16(lv.ruleRange[i]);
+				const __m256i add = _mm256_set1_epi16(lv.ruleAdd[i]);
+				addLo = _mm256_blendv_epi8(addLo, add, _mm256_cmpgt_epi16(range, sumLo));
+				addHi = _mm256_blendv_epi8(addHi, add, _mm256_cmpgt_epi16(range, sumHi));
+			}
+
+			const __m256i oldState = _mm256_loadu_si256((const __m256i*)cellPtr);
+			__m256i newLo = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(oldState)), addLo);
+			__m256i newHi = _mm256_add_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(oldState,1)), addHi);
+			newLo = _mm256_min_epi16(_mm256_max_epi16(newLo,zero),maxState);
+			newHi = _mm256_min_epi16(_mm256_max_epi16(newHi,zero),maxState);
+			const __m256i newState = _mm256_permute4x64_epi64(_mm256_packus_epi16(newLo,newHi), 0xD8); //packus interleaves 128-bit lanes
+
+			_mm256_storeu_si256((__m256i*)(writeBuf + rowInd + ty), newState);
+			changeAny = _mm256_or_si256(changeAny, _mm256_xor_si256(newState,oldState));
+		}
+		changed |= !_mm256_testz_si256(changeAny, changeAny);
+		return ty;
+	}
+#endif
+};
@@ -1,6 +1,6 @@
 /**
  * @file kaelifeCALock.hpp
- * 
+ *
  * @brief CAData thread locks
 */
 
@@ -12,89 +12,134 @@
 #include <vector>
 #include <chrono>
 #include <atomic>
-#include <mutex>
-#include <condition_variable>
-#include <numeric>
+#include <memory>
+
+/**
+ * @brief Reusable thread barrier whose thread count can change between phases
+ *
+ * std::barrier count is fixed at construction, this one is set by setCount while no thread is waiting
+*/
+class CABarrier {
+private:
+	alignas(64) std::atomic<uint32_t> arrived = 0;
+	alignas(64) std::atomic<uint32_t> phase = 0; //incremented when the last thread arrives
+	uint32_t count;
+
+public:
+	CABarrier(uint32_t threadCount) : count(threadCount) {}
+
+	/**
+	 * @brief Wait until count threads have arrived
+	*/
+	void arrive_and_wait() {
+		const uint32_t current = phase.load(std::memory_order_acquire);
+		if(arrived.fetch_add(1, std::memory_order_acq_rel)+1 == count){
+			arrived.store(0, std::memory_order_relaxed); //next phase starts after phase changes
+			phase.fetch_add(1, std::memory_order_release);
+			phase.notify_all();
+			return;
+		}
+		phase.wait(current, std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Set number of threads for next phases
+	 *
+	 * @note no thread may be at arrive_and_wait
+	*/
+	void setCount(uint32_t threadCount) {
+		count = threadCount;
+	}
+};
 
 /**
  * @brief CAData and Main thread synchronization and locking
- * 
+ *
+ * Main thread publishes a task by incrementing epoch. Each thread stores the epoch it finished to its own slot
+ * and sleeps on epoch with std::atomic::wait until main publishes the next one.
+ * Main sleeps on arrivals until every slot has reached the current epoch. No mutex is taken,
+ * a thread that arrives after the epoch changed continues without sleeping
 */
 class CALock {
 private:
-	std::vector<bool> resumeWaitPool;
-	std::atomic<bool> allThreadsWaiting = false;
+	/**
+	 * @brief One thread's state, own cache line so threads don't invalidate each other's slot
+	*/
+	struct alignas(64) ThreadSlot {
+		std::atomic<uint64_t> arrivedEpoch = 0; //epoch whose task this thread finished. Read by main
+		uint64_t consumedEpoch = 0; //epoch whose task this thread runs. Thread private
+	};
 
-	uint threadCount;
-	
-	std::mutex resumeMutex;
-	std::mutex mainMutex;
-	std::condition_variable resumeCV;
-	std::condition_variable mainCV;
+	alignas(64) std::atomic<uint64_t> epoch = 0; //incremented by continueThread
+	alignas(64) std::atomic<uint32_t> arrivals = 0; //incremented by each waitResume, main waits on it
+	alignas(64) std::atomic<int> transferIterRepeats = 0;
+	std::atomic<bool> transferActiveBuf = 0;
 
-    std::atomic<bool> isThreadPaused=false; //each thread has it's own memory location to prevent data racing without using per thread mutex
-	std::vector<int> transferIterRepeats;
-	std::atomic<bool> transferActiveBuf=0;
+	std::unique_ptr<ThreadSlot[]> slots;
+	std::atomic<uint> threadCount = 0; //slots in use. 0 until expectedThreadCount
 
 public:
     std::atomic<bool> isThreadTerminated=false;
-	
+
     CALock() {
-		threadCount=1;
-		isThreadPaused=1; //start paused
 		isThreadTerminated=0;
 	}
 
 	/**
-	 * @brief Count how many threads are waiting
+	 * @brief Whether every thread is at waitResume() of the current epoch
 	*/
-	uint getPoolSize(std::vector<bool> &pool){
-		return std::accumulate(pool.begin(),pool.end(),0);
+	bool allThreadsWaiting(){
+		const uint count = threadCount.load(std::memory_order_acquire);
+		if(count==0){ return 0; } //threads are not started yet
+		const uint64_t current = epoch.load(std::memory_order_acquire);
+		for(uint i=0;i<count;i++){
+			if(slots[i].arrivedEpoch.load(std::memory_order_acquire)!=current){ return 0; }
+		}
+		return 1;
 	}
 
 	//
 	/**
 	 * @brief child threads waiting for main thread resume signal
-	 * 
+	 *
 	 * @param threadId
 	 * @param receiveIterRepeats //Thread unique cache tasks to do
 	 * @param currentBuf //Thread unique cache activeBuf
 	*/
 	void waitResume(uint threadId, uint* receiveIterRepeats, bool* currentBuf) {
-		{
-			std::unique_lock<std::mutex> lock(resumeMutex);
-			resumeWaitPool[threadId]=1;
-			if(getPoolSize(resumeWaitPool)==threadCount){
-				allThreadsWaiting.store(1);
-				mainCV.notify_all();
-			}
-			resumeCV.wait(lock, [&] { return (transferIterRepeats[threadId] != -1); }); //threads enter pause
-			resumeWaitPool[threadId]=0;
-			allThreadsWaiting=0;
-		}
+		ThreadSlot &slot = slots[threadId];
+		slot.arrivedEpoch.store(slot.consumedEpoch, std::memory_order_release);
+		arrivals.fetch_add(1, std::memory_order_release);
+		arrivals.notify_one();
+
+		epoch.wait(slot.consumedEpoch, std::memory_order_acquire); //threads enter pause
+		slot.consumedEpoch = epoch.load(std::memory_order_acquire);
 
-		*receiveIterRepeats=transferIterRepeats[threadId]; 
-		*currentBuf=transferActiveBuf.load();
-		transferIterRepeats[threadId]=-1;
+		*receiveIterRepeats=transferIterRepeats.load(std::memory_order_relaxed);
+		*currentBuf=transferActiveBuf.load(std::memory_order_relaxed);
 	}
 
 	/**
 	 * @brief main thread confirms that all threads are at waitResume()
 	*/
 	void syncMainThread(){
-		std::unique_lock<std::mutex> lock(mainMutex);
-		mainCV.wait(lock, [&] { return allThreadsWaiting.load(); }); //main waits threads to enter pause
+		while(1){
+			const uint32_t seen = arrivals.load(std::memory_order_acquire);
+			if(allThreadsWaiting()){ return; }
+			arrivals.wait(seen, std::memory_order_acquire); //main waits threads to enter pause
+		}
 	}
 
 	/**
 	 * @brief Tell threads it's safe to continue
-	 * 
+	 *
 	 * @note call in main thread after syncMainThread in next cycle
 	*/
     void continueThread(uint iters,uint activeBuf) {
-		std::fill(transferIterRepeats.begin(),transferIterRepeats.end(),iters); 
-		transferActiveBuf=activeBuf;
-		resumeCV.notify_all();
+		transferIterRepeats.store(iters, std::memory_order_relaxed);
+		transferActiveBuf.store(activeBuf, std::memory_order_relaxed);
+		epoch.fetch_add(1, std::memory_order_release); //publishes the task
+		epoch.notify_all();
 	}
 
 	/**
@@ -107,13 +152,16 @@ public:
 
 	/**
 	 * @brief Set number of expected thread count
-	 * 
-	 * @note important to be same as CAData startWorkerThreads thread count
+	 *
+	 * @note important to be same as CAData startWorkerThreads thread count. Call before threads start
 	*/
 	void expectedThreadCount(uint tc){
-		threadCount=tc;
-		transferIterRepeats.resize(tc,-1);
-		resumeWaitPool.resize(tc,0);
+		slots.reset(new ThreadSlot[tc]);
+		for(uint i=0;i<tc;i++){ //started threads wait for the next task
+			slots[i].consumedEpoch = epoch.load();
+			slots[i].arrivedEpoch.store(slots[i].consumedEpoch - 1); //not waiting before the thread calls waitResume
+		}
+		threadCount.store(tc, std::memory_order_release);
 	}
-		
-};
\ No newline at end of file
+
+};
@@ -0,0 +1,147 @@
+/**
+ * @file kaelifeCANuma.hpp
+ *
+ * @brief CAData NUMA topology and thread pinning
+*/
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+#if defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+/**
+ * @brief NUMA nodes and their CPUs read from /sys/devices/system/node
+ *
+ * Without sysfs every online CPU is in node 0. Linux pages are placed on the node of the thread that first touches them,
+ * so a pinned thread that first touches its stripe keeps its memory traffic on its own node
+*/
+class CANuma {
+public:
+	/**
+	 * @brief Read topology. Not thread safe
+	*/
+	CANuma() {
+		for(uint node=0;;node++){
+			std::ifstream file("/sys/devices/system/node/node"+std::to_string(node)+"/cpulist");
+			if(!file){ break; }
+			std::string list;
+			std::getline(file, list);
+			std::vector<uint> cpus = parseCpuList(list);
+			if(!cpus.empty()){
+				nodeCpus.push_back(cpus);
+			}
+		}
+		if(nodeCpus.empty()){
+			uint cpuCount = std::max(std::thread::hardware_concurrency(), 1u);
+			nodeCpus.emplace_back();
+			for(uint cpu=0;cpu<cpuCount;cpu++){
+				nodeCpus[0].push_back(cpu);
+			}
+		}
+	}
+
+	/** @brief Number of NUMA nodes with CPUs */
+	uint nodeCount() const {
+		return nodeCpus.size();
+	}
+
+	/**
+	 * @brief CPU of thread. Threads fill node 0 first, so neighboring stripes share a node
+	*/
+	uint threadCpu(uint threadId) const {
+		uint total = 0;
+		for(const auto &cpus : nodeCpus){ total += cpus.size(); }
+		uint i = threadId%total;
+		for(const auto &cpus : nodeCpus){
+			if(i<cpus.size()){ return cpus[i]; }
+			i -= cpus.size();
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Node of cpu, 0 if unknown
+	*/
+	uint cpuNode(uint cpu) const {
+		for(uint node=0;node<nodeCpus.size();node++){
+			for(const uint c : nodeCpus[node]){
+				if(c==cpu){ return node; }
+			}
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief Pin calling thread to cpu
+	 *
+	 * @return false if pinning isn't supported or failed
+	*/
+	static bool pinThread(uint cpu) {
+		#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set)==0;
+		#else
+			(void)cpu;
+			return 0;
+		#endif
+	}
+
+	/**
+	 * @brief Let calling thread run on every CPU of every node again
+	 *
+	 * @return false if pinning isn't supported or failed
+	*/
+	bool unpinThread() const {
+		#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			for(const auto &cpus : nodeCpus){
+				for(const uint cpu : cpus){ CPU_SET(cpu, &set); }
+			}
+			return pthread_setaffinity_np(pthread_self(), sizeof(set), &set)==0;
+		#else
+			return 0;
+		#endif
+	}
+
+private:
+	std::vector<std::vector<uint>> nodeCpus;
+
+	/**
+	 * @brief Parse sysfs cpu list like "0-3,8-11"
+	*/
+	static std::vector<uint> parseCpuList(const std::string &list) {
+		std::vector<uint> cpus;
+		const char* ptr = list.c_str();
+		while(*ptr){
+			char* end;
+			uint first = std::strtoul(ptr, &end, 10);
+			if(end==ptr){ break; } //malformed
+			uint last = first;
+			ptr = end;
+			if(*ptr=='-'){
+				last = std::strtoul(ptr+1, &end, 10);
+				ptr = end;
+			}
+			for(uint cpu=first;cpu<=last;cpu++){
+				cpus.push_back(cpu);
+			}
+			if(*ptr!=','){ break; }
+			ptr++;
+		}
+		return cpus;
+	}
+};
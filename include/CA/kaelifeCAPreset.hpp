@@ -6,10 +6,9 @@
 
 #pragma once
 
-#include "kaelifeSDL.hpp"
 #include "kaelRandom.hpp"
-#include "kaelife.hpp"
 #include "kaelifeWorldMatrix.hpp"
+#include "kaelifeCACell.hpp"
 
 #include <iostream>
 #include <vector>
@@ -19,12 +18,17 @@
 #include <cstring>
 #include <algorithm>
 #include <mutex>
+#include <array>
 
 /**
  * @brief Cellular automata preset manager
+ *
+ * @tparam Cell cellState cell type. Wider cells allow more states and bigger adds, mask weights stay 8-bit
 */
-class CAPreset {
+template<typename Cell>
+class CAPresetT {
 public:
+	typedef CACellTraits<Cell> Traits;
 	static constexpr const size_t maxNameLength = 32;
 	static constexpr const char* unsetName = "UNNAMED";
 
@@ -34,17 +38,17 @@ public:
 	struct RulePreset {
     	std::string name;
 		uint stateCount;
-		std::vector<int16_t> ruleRange;
-		std::vector<int8_t> ruleAdd;
-		uint8_t clipTreshold;
+		std::vector<typename Traits::Range> ruleRange;
+		std::vector<typename Traits::Add> ruleAdd;
+		Cell clipTreshold;
 		WorldMatrix<uint8_t> neigMask;
 		uint64_t presetSeed;
 
 		RulePreset(
 			std::string n = unsetName,
 			uint sc = 0,
-			const std::vector<int16_t>& rr = {0},
-			const std::vector<int8_t>& ra = {0, 0},
+			const std::vector<typename Traits::Range>& rr = {0},
+			const std::vector<typename Traits::Add>& ra = {0, 0},
 			const WorldMatrix<uint8_t>& m =
 			{
 				{UINT8_MAX, UINT8_MAX, UINT8_MAX},
@@ -128,11 +132,39 @@ private:
 		}
 	}; 
 
+	/**
+	 * @brief Presets that need more than 256 states. Appended to list if cells are wider than 8 bits
+	*/
+	inline static const std::vector<RulePreset> wideList = 
+	{
+		{
+			"Hexagon4096", //Hexagon with 16 times finer states, ranges and adds
+			4096,
+			{352,1616,1632,1728,2816,3376,4432,5392,6480,9104,10864,13120,18880,20624,22576,23072},
+			{-1088,-800,272,1984,1776,-992,-480,1376,-304,-32,-1168,992,-1696,1200,1120,-1216,-1264},
+			{
+				{  0, 16,255, 16,  0},
+				{255, 16,  0, 16,255},
+				{ 16,  0,  0,  0, 16},
+				{255, 16,  0, 16,255},
+				{  0, 16,255, 16,  0}
+			}
+		},{
+			"Gradient", //slow additive waves through 60000 states
+			60000,
+			{4000,20000,44000,80000,140000},
+			{900,300,-200,-600,400,-1000}
+		}
+	};
+
 public:
 	std::mutex indexMutex;
 	uint index=0; //current preset index
 
-	CAPreset() {
+	CAPresetT() {
+		if constexpr(sizeof(Cell)>1){
+			list.insert(list.end(), wideList.begin(), wideList.end());
+		}
 		setPreset(0);
         for (auto& automata : list) {
             if (automata.presetSeed != UINT64_MAX) {
@@ -447,7 +479,7 @@ public:
 		 * @param maxValue max rule range
 		 * @param seed seed. Default kaelife::rand() instance seed
 		*/
-		void randRuleRange(const uint ind, uint16_t minValue, uint16_t maxValue=0, uint64_t* seed=nullptr ) {
+		void randRuleRange(const uint ind, uint minValue, uint maxValue=0, uint64_t* seed=nullptr ) {
 			maxValue = maxValue ? maxValue :  calcMaxNeigsum(ind);
 			uint64_t* seedPtr = kaelife::rand.validSeedPtr(seed);
 			uint rangeSize=list[ind].ruleRange.size();
@@ -456,7 +488,7 @@ public:
 			uint current=minValue;
 			uint i;
 			for(i=0; i<rangeSize; ++i){
-				uint16_t addMax = 2*(((maxValue)-current+1)/(rangeSize-i)); //divide maxValue, current delta by remaining elements
+				uint addMax = 2*(((maxValue)-current+1)/(rangeSize-i)); //divide maxValue, current delta by remaining elements
 				addMax+=addMax==0; //prevent divide by 0
 				current+= kaelife::rand(seedPtr)%addMax; //add to next range
 				list[ind].ruleRange.push_back(current);
@@ -473,7 +505,7 @@ public:
 		 * @param maxValue max rule add
 		 * @param seed seed. Default kaelife::rand() instance seed
 		*/
-		void randRuleAdd(const uint ind, int8_t minValue=0, int8_t maxValue=0, uint64_t* seed=nullptr ) {
+		void randRuleAdd(const uint ind, typename Traits::Add minValue=0, typename Traits::Add maxValue=0, uint64_t* seed=nullptr ) {
 			uint64_t* seedPtr = kaelife::rand.validSeedPtr(seed);
 
 			if(minValue==0 && maxValue==0){
@@ -482,7 +514,7 @@ public:
 				uint m1 = kaelife::rand(seedPtr)%cellStates;
 				uint medRand = std::sqrt((uint)m0*m1); //geometric mean
 				medRand = (uint)std::round( std::lerp<uint,uint,double>(medRand,0,0.25) ); //shift median to first quarter
-				medRand = std::clamp(medRand,(uint)1,(uint)127);
+				medRand = std::clamp(medRand,(uint)1,(uint)std::numeric_limits<typename Traits::Add>::max());
 				maxValue= medRand;
 				minValue=-medRand;
 			}
@@ -503,7 +535,7 @@ public:
 			uint64_t* seedPtr = kaelife::rand.validSeedPtr(seed);
 			uint64_t startSeed=*seedPtr;
 			
-			list[ind].stateCount=kaelife::rand(seedPtr)%(UINT8_MAX-1)+2;
+			list[ind].stateCount=kaelife::rand(seedPtr)%(Traits::maxCell-1)+2;
 			uint maxMask=7;
 			uint newMaskX=kaelife::rand(seedPtr)%maxMask+1;
 			uint newMaskY=kaelife::rand(seedPtr)%maxMask+1;
@@ -517,7 +549,7 @@ public:
 			list[ind].ruleAdd.resize(maxRules+2);
 
 			int rr= (kaelife::rand(seedPtr)%list[ind].stateCount)/2;
-			rr=std::clamp(rr,1,127);
+			rr=std::clamp(rr,1,(int)std::numeric_limits<typename Traits::Add>::max());
 			randRuleAdd(ind,-rr,rr,seedPtr);
 			randRuleRange(ind,0,maxNeigSum,seedPtr);
 			
@@ -599,9 +631,14 @@ private:
 			}
 			if(ind >= list.size()){ind=UINT_MAX;}
 		}else{
-			static_assert(false, "Invalid dst type");
+			static_assert(sizeof(T1)==0, "Invalid dst type");
 		}
 		return ind;
 	}
 
 };
+
+/**
+ * @brief Presets of the default 8-bit world
+*/
+typedef CAPresetT<uint8_t> CAPreset;
\ No newline at end of file
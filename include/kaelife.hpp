@@ -20,6 +20,6 @@
 */
 namespace kaelife {
     SDL_GLContext initSDL(SDL_Window* &SDLWindow, int windowWidth, int windowHeight);  
-    void worldCore(CAData &kaelife, InputHandler &kaeInput, CARender &kaeRender, SDL_Window* &SDLWindow);
-    void placeHolderDraw(CAData &kaelife);
+    template<typename Cell> void worldCore(CADataT<Cell> &kaelife, CARenderT<Cell> &kaeRender, InputHandlerT<Cell> &kaeInput, SDL_Window* &SDLWindow);
+    template<typename Cell> void placeHolderDraw(CADataT<Cell> &kaelife);
 }
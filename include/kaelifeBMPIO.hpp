@@ -9,15 +9,18 @@
 
 #include "kaelifeWorldMatrix.hpp"
 #include "CA/kaelifeCAData.hpp"
-#include "kaelife.hpp"
 
 #include <iostream>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
 
 namespace kaelife {
 	/**
 	 * @brief eventually make this bitmap import export
 	*/
-	void placeHolderDraw(CAData &cellData){
+	template<typename Cell>
+	void placeHolderDraw(CADataT<Cell> &cellData){
 	
 		uint rows = cellData.mainCache.tileRows;
 		uint cols = cellData.mainCache.tileCols;
@@ -44,8 +47,8 @@ namespace kaelife {
 					aj=(aj+cols)%cols;
 					bi=(bi+rows)%rows;
 					bj=(bj+cols)%cols;
-					cellData.cellState[!cellData.mainCache.activeBuf][ai][aj] = flier[i][j]; //write to inactive buffer
-					cellData.cellState[!cellData.mainCache.activeBuf][bi][bj] = flier[i][j];
+					cellData.cellState[cellData.mainCache.activeBuf][ai][aj] = flier[i][j]; //write to active buffer, cloneBuffer publishes it
+					cellData.cellState[cellData.mainCache.activeBuf][bi][bj] = flier[i][j];
 				}
 			}
 
@@ -70,17 +73,58 @@ namespace kaelife {
 						ofy=ofy*k-(2*(k==2)-(3)*(k==0));
 						ofx=((i+posx+ofx)+rows)%rows;
 						ofy=((j+posy+ofy)+cols)%cols;
-						cellData.cellState[!cellData.mainCache.activeBuf][ofx][ofy] = diagonalFlier[i][j]; //maybe possible to keep them alive together
+						cellData.cellState[cellData.mainCache.activeBuf][ofx][ofy] = diagonalFlier[i][j]; //maybe possible to keep them alive together
 					}
 				}
 			}
 
 		//border test
-	//	cellData.cellState[!cellData.mainCache.activeBuf][0][0]=1;
-	//	cellData.cellState[!cellData.mainCache.activeBuf][cellData.mainCache.tileRows-1][0]=2;
-	//	cellData.cellState[!cellData.mainCache.activeBuf][cellData.witmainCache.tileRows-1][cellData.mainCache.tileCols-1]=3;
+	//	cellData.cellState[cellData.mainCache.activeBuf][0][0]=1;
+	//	cellData.cellState[cellData.mainCache.activeBuf][cellData.mainCache.tileRows-1][0]=2;
+	//	cellData.cellState[cellData.mainCache.activeBuf][cellData.witmainCache.tileRows-1][cellData.mainCache.tileCols-1]=3;
 
 		cellData.backlog->add("cloneBuffer");
 		cellData.backlog->doBacklog();
 	}
+
+	/**
+	 * @brief Write cellState[mainCache.activeBuf] as binary PGM. Pixel value is the cell state. Not thread safe
+	 * 
+	 * Image is X wide and Y tall with Y up like the render. Worlds of more than 256 states are written as 16-bit big endian PGM
+	 * 
+	 * @return false if the file couldn't be written
+	*/
+	template<typename Cell>
+	bool exportPGM(CADataT<Cell> &cellData, const char* path){
+		FILE* file = fopen(path, "wb");
+		if(!file){
+			printf("Failed to open %s\n", path);
+			return false;
+		}
+		const uint rows = cellData.mainCache.tileRows;
+		const uint cols = cellData.mainCache.tileCols;
+		const uint maxState = std::max(cellData.mainCache.stateCount, 2u)-1;
+		fprintf(file, "P5\n%u %u\n%u\n", rows, cols, maxState);
+
+		const CAGrid<Cell> &grid = cellData.cellState[cellData.mainCache.activeBuf];
+		const uint sampleBytes = maxState>UINT8_MAX ? 2 : 1;
+		std::vector<uint8_t> line(rows*sampleBytes);
+		bool ok = true;
+		for(uint y=cols;y-->0;){ //first image line is the top
+			for(uint x=0;x<rows;x++){
+				if(sampleBytes==2){
+					line[2*x] = grid[x][y]>>8;
+					line[2*x+1] = grid[x][y];
+				}else{
+					line[x] = grid[x][y];
+				}
+			}
+			ok &= fwrite(line.data(), 1, line.size(), file)==line.size();
+		}
+		ok &= fclose(file)==0;
+		if(!ok){
+			printf("Failed to write %s\n", path);
+		}
+		return ok;
+	}
 }
\ No newline at end of file
@@ -23,7 +23,8 @@
 /**
  * @brief Manage SDL2 user input
  *
- * @param CAData &inCAData 
+ * @tparam Cell cellState cell type
+ * @param CADataT<Cell> &inCAData 
  * @param SDL_Window *&inSDL_Window
  *
  * controls
@@ -37,23 +38,30 @@
  * Simu Speed....... [1]:-1 [3]:+1
  * Pause............ [2], [Shift]+[P]
  * Iterate once..... [4]
+ * Pipelined sim.... [L]
+ * NUMA placement... [Shift]+[L]
+ * World size....... [-]:half [=]:double, up to maxWorldBytes per buffer
+ * Threads.......... [5]:-1 [6]:+1
  * Print rules...... [P]
  * Switch automata.. [,] [.]
+ * Switch kernel.... [K]
+ * Gens per tile.... [Shift]+[K]
  * Shader Color..... [Shift]+[N]
- * print frameTime.. [F]
+ * print timings.... [F]
  * Hue--............ [Shift]+[Q]
  * Hue++............ [Shift]+[E]
  * Color stagger--.. [Alt]+[Q]
  * Color stagger++.. [Alt]+[E]
  * Exit:............ [ESC]
  */
-class InputHandler {
+template<typename Cell>
+class InputHandlerT {
 private:
 
-    CAData& cellData;
+    CADataT<Cell>& cellData;
     SDL_Window*& SDLWindow;
 	// Map key combinations to functions
-	std::map<SDL_Keycode, std::function<void(CAData&)>> keyFuncMap;
+	std::map<SDL_Keycode, std::function<void(CADataT<Cell>&)>> keyFuncMap;
 
     // Map to store the state of keys or mouse buttons
     std::map<int, bool> keyStates;
@@ -83,6 +91,7 @@ public:
 	bool stepFrame=false;
 	bool displayFrameTime=false;
 	bool pause=false;
+	bool pipelined=false; //simulate on own thread and render published frames, see kaelife::simulationCore
 	
 	int drawRadius=2;
 	float drawStrength=1.0;
@@ -108,37 +117,45 @@ public:
 	
 	//TODO: a new overhauled keymapping wouldn't hurt. This worked for few inputs but is starting to feel yank and inflexible
 	// Initialize key mappings in the constructor
-	InputHandler(
-		CAData &inCAData, 
+	InputHandlerT(
+		CADataT<Cell> &inCAData, 
 		SDL_Window*& inSDL_Window
 	) : 
 		cellData(inCAData), 
 		SDLWindow(inSDL_Window),
 		keyFuncMap
 	{
-			{SDLK_r					 		, 	std::bind(&InputHandler::press_r, 			this )},
-			{SDLK_t					 		, 	std::bind(&InputHandler::press_t, 			this )},
-			{SDLK_q					 		, 	std::bind(&InputHandler::press_q, 			this )},
-			{SDLK_e					 		, 	std::bind(&InputHandler::press_e, 			this )},
-			{SDLK_1					 		, 	std::bind(&InputHandler::press_1, 			this )},
-			{SDLK_2					 		, 	std::bind(&InputHandler::press_2, 			this )},
-			{SDLK_3					 		, 	std::bind(&InputHandler::press_3, 			this )},
-			{SDLK_4					 		, 	std::bind(&InputHandler::press_4, 			this )},
-			{SDLK_p					 		, 	std::bind(&InputHandler::press_p, 			this )},
-			{SDLK_w					 		, 	std::bind(&InputHandler::press_w, 			this )},
-			{SDLK_f					 		, 	std::bind(&InputHandler::press_f, 			this )},
-			{SDLK_m					 		, 	std::bind(&InputHandler::press_m, 			this )},
-			{SDLK_n					 		, 	std::bind(&InputHandler::press_n, 			this )},
-			{SDLK_y					 		, 	std::bind(&InputHandler::press_y, 			this )},
-			{SDLK_q	| (KMOD_LALT<<16)		, 	std::bind(&InputHandler::press_q_LALT, 		this )},
-			{SDLK_e	| (KMOD_LALT<<16)		, 	std::bind(&InputHandler::press_e_LALT, 		this )},
-			{SDLK_q	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandler::press_q_LSHIFT, 	this )},
-			{SDLK_e	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandler::press_e_LSHIFT, 	this )},
-			{SDLK_n	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandler::press_n_LSHIFT, 	this )},
-			{SDLK_p	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandler::press_p_LSHIFT, 	this )},
-			{SDLK_PERIOD					, 	std::bind(&InputHandler::press_PERIOD, 		this )},
-			{SDLK_COMMA						, 	std::bind(&InputHandler::press_COMMA, 		this )},
-			{SDLK_ESCAPE			 		, 	std::bind(&InputHandler::press_ESCAPE, 		this )}
+			{SDLK_r					 		, 	std::bind(&InputHandlerT::press_r, 			this )},
+			{SDLK_t					 		, 	std::bind(&InputHandlerT::press_t, 			this )},
+			{SDLK_q					 		, 	std::bind(&InputHandlerT::press_q, 			this )},
+			{SDLK_e					 		, 	std::bind(&InputHandlerT::press_e, 			this )},
+			{SDLK_1					 		, 	std::bind(&InputHandlerT::press_1, 			this )},
+			{SDLK_2					 		, 	std::bind(&InputHandlerT::press_2, 			this )},
+			{SDLK_3					 		, 	std::bind(&InputHandlerT::press_3, 			this )},
+			{SDLK_4					 		, 	std::bind(&InputHandlerT::press_4, 			this )},
+			{SDLK_5					 		, 	std::bind(&InputHandlerT::press_5, 			this )},
+			{SDLK_6					 		, 	std::bind(&InputHandlerT::press_6, 			this )},
+			{SDLK_p					 		, 	std::bind(&InputHandlerT::press_p, 			this )},
+			{SDLK_w					 		, 	std::bind(&InputHandlerT::press_w, 			this )},
+			{SDLK_f					 		, 	std::bind(&InputHandlerT::press_f, 			this )},
+			{SDLK_m					 		, 	std::bind(&InputHandlerT::press_m, 			this )},
+			{SDLK_n					 		, 	std::bind(&InputHandlerT::press_n, 			this )},
+			{SDLK_y					 		, 	std::bind(&InputHandlerT::press_y, 			this )},
+			{SDLK_k					 		, 	std::bind(&InputHandlerT::press_k, 			this )},
+			{SDLK_l					 		, 	std::bind(&InputHandlerT::press_l, 			this )},
+			{SDLK_q	| (KMOD_LALT<<16)		, 	std::bind(&InputHandlerT::press_q_LALT, 		this )},
+			{SDLK_e	| (KMOD_LALT<<16)		, 	std::bind(&InputHandlerT::press_e_LALT, 		this )},
+			{SDLK_q	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_q_LSHIFT, 	this )},
+			{SDLK_e	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_e_LSHIFT, 	this )},
+			{SDLK_n	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_n_LSHIFT, 	this )},
+			{SDLK_p	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_p_LSHIFT, 	this )},
+			{SDLK_k	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_k_LSHIFT, 	this )},
+			{SDLK_l	| (KMOD_LSHIFT<<16)		, 	std::bind(&InputHandlerT::press_l_LSHIFT, 	this )},
+			{SDLK_PERIOD					, 	std::bind(&InputHandlerT::press_PERIOD, 		this )},
+			{SDLK_COMMA						, 	std::bind(&InputHandlerT::press_COMMA, 		this )},
+			{SDLK_MINUS						, 	std::bind(&InputHandlerT::press_MINUS, 		this )},
+			{SDLK_EQUALS					, 	std::bind(&InputHandlerT::press_EQUALS, 		this )},
+			{SDLK_ESCAPE			 		, 	std::bind(&InputHandlerT::press_ESCAPE, 		this )}
 
 	} {}
 
@@ -151,20 +168,28 @@ public:
 	void press_2();
 	void press_3();
 	void press_4();
+	void press_5();
+	void press_6();
 	void press_p();
 	void press_w();
 	void press_f();
 	void press_m();
 	void press_n();
 	void press_y();
+	void press_k();
+	void press_l();
 	void press_q_LALT();
 	void press_e_LALT();
 	void press_q_LSHIFT();
 	void press_e_LSHIFT();
 	void press_n_LSHIFT();
 	void press_p_LSHIFT();
+	void press_k_LSHIFT();
+	void press_l_LSHIFT();
 	void press_PERIOD();
 	void press_COMMA();
+	void press_MINUS();
+	void press_EQUALS();
 	void press_ESCAPE();
 
 
@@ -176,34 +201,63 @@ public:
 	std::array<int, 2>   getWorldCursorPos ();
 };
 
+/** @brief Default 8-bit world input */
+typedef InputHandlerT<uint8_t> InputHandler;
 
 
-
-int InputHandler::cursorPos[2] = {0, 0};
+template<typename Cell>
+int InputHandlerT<Cell>::cursorPos[2] = {0, 0};
 
 // Function implementations
 	//randomize all
-	void InputHandler::press_y(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_y(){
 		cellData.backlog->add("randAll");
 	};
 	//random mask
-	void InputHandler::press_n(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_n(){
 		cellData.backlog->add("randMask");
 	};
 	//randomize ranges
-	void InputHandler::press_r(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_r(){
 		cellData.backlog->add("randRange");
 	};
 	//randomize adds
-	void InputHandler::press_t(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_t(){
 		cellData.backlog->add("randAdd");
 	};
 	//rand mutate
-	void InputHandler::press_m(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_m(){
 		cellData.backlog->add("randMutate");
 	};
+	//next iteration kernel
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_k(){
+		cellData.backlog->add("nextKernel");
+	};
+	//toggle pipelined simulation
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_l(){
+		pipelined=!pipelined;
+		printf("Pipelined: %d\n", pipelined);
+	};
+	//next temporal blocking depth
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_k_LSHIFT(){
+		cellData.backlog->add("nextTemporalDepth");
+	};
+	//toggle NUMA pinning and placement
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_l_LSHIFT(){
+		cellData.backlog->add("toggleNuma");
+	};
 	//shader color stagger--
-	void InputHandler::press_q_LALT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_q_LALT(){
 		uint8_t add=std::min(holdAccel*holdAccel/40.0f,3.0f)+1;
 		colorStagger-=add;
 		if(kaelife::INPUT_DEBUG){
@@ -211,7 +265,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//shader color stagger++
-	void InputHandler::press_e_LALT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_e_LALT(){
 		uint8_t add=std::min(holdAccel*holdAccel/40.0f,3.0f)+1;
 		colorStagger+=add;
 		if(kaelife::INPUT_DEBUG){
@@ -219,7 +274,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//shader hue--
-	void InputHandler::press_q_LSHIFT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_q_LSHIFT(){
 		uint8_t add=std::min(holdAccel*holdAccel/40.0f,3.0f)+1;
 		shaderHue-=add;
 		if(kaelife::INPUT_DEBUG){
@@ -227,7 +283,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//shader hue++
-	void InputHandler::press_e_LSHIFT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_e_LSHIFT(){
 		uint8_t add=std::min(holdAccel*holdAccel/40.0f,3.0f)+1;
 		shaderHue+=add;
 		if(kaelife::INPUT_DEBUG){
@@ -236,7 +293,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 	};
 
 	//draw radius--
-	void InputHandler::press_q(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_q(){
 		float sub=(holdAccel*holdAccel/10)+1;
 		if( ((float)drawRadius-sub)>1 ){
 			drawRadius-=(uint)sub;
@@ -248,7 +306,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//draw radius++
-	void InputHandler::press_e(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_e(){
 		float add=(holdAccel*holdAccel/10)+1;
 		if( ((float)drawRadius+add)<255 ){
 			drawRadius+=(uint)add;
@@ -261,7 +320,8 @@ int InputHandler::cursorPos[2] = {0, 0};
 	};
 
 	//slow down sim
-	void InputHandler::press_1(){ 
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_1(){ 
 		float sub=(holdAccel*holdAccel)/1000.0;
 		if(simSpeed>(sub+0.01)){
 			simSpeed-=sub;
@@ -274,14 +334,16 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//pause
-	void InputHandler::press_2(){ 
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_2(){ 
 		pause=!pause;
 		if(kaelife::INPUT_DEBUG){
 			printf("pause: %d\n", pause);
 		}
 	};
 	//speed up sim
-	void InputHandler::press_3(){ 
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_3(){ 
 		float add=(holdAccel*holdAccel)/1000.0;
 		if(simSpeed<1000){
 			simSpeed+=add;
@@ -294,33 +356,48 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//progress one sim step
-	void InputHandler::press_4(){ 
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_4(){ 
 		stepFrame=1;
 		if(kaelife::INPUT_DEBUG){
 			printf("stepFrame: %d\n",stepFrame);
 		}
 	};
+	//iterate with one thread less
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_5(){
+		cellData.backlog->add("lessThreads");
+	};
+	//iterate with one thread more
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_6(){
+		cellData.backlog->add("moreThreads");
+	};
 	//draw random
-	void InputHandler::press_w(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_w(){
 		drawRandom=!drawRandom;
 		if(kaelife::INPUT_DEBUG){
 			printf("drawRandom: %d\n",drawRandom);
 		}
 	};
 	//print rules
-	void InputHandler::press_p(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_p(){
 		cellData.kaePreset.printPreset();
 		printf("Shader {%d,%d},\n",shaderHue,colorStagger);
 	};
 	//show frame time
-	void InputHandler::press_f(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_f(){
 		displayFrameTime=!displayFrameTime;
 		if(kaelife::INPUT_DEBUG){
 			printf("displayFrameTime: %d\n", displayFrameTime);
 		}
 	};
 	//use nomral
-	void InputHandler::press_n_LSHIFT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_n_LSHIFT(){
 		shaderColor++;
 		shaderColor=(shaderColor)%2;
 		if(kaelife::INPUT_DEBUG){
@@ -328,21 +405,24 @@ int InputHandler::cursorPos[2] = {0, 0};
 		}
 	};
 	//show kaelife::INPUT_DEBUG 
-	void InputHandler::press_p_LSHIFT(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_p_LSHIFT(){
 		pause=!pause;
 		if(kaelife::INPUT_DEBUG){
 			printf("pause: %d\n", pause);
 		}
 	};
 	//quit
-	void InputHandler::press_ESCAPE(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_ESCAPE(){
 		QUIT_FLAG = true;
 		if(kaelife::INPUT_DEBUG){
 			printf("Exit\n");
 		}
 	};
 	//next preset
-	void InputHandler::press_PERIOD(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_PERIOD(){
 		int ind =cellData.kaePreset.nextPreset();
 		if(kaelife::INPUT_DEBUG){
 			printf("preset: %d\n",ind);
@@ -351,17 +431,29 @@ int InputHandler::cursorPos[2] = {0, 0};
 		cellData.backlog->add("loadPreset");
 	};
 	//previous preset
-	void InputHandler::press_COMMA(){
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_COMMA(){
 		int ind = cellData.kaePreset.prevPreset();
 		if(kaelife::INPUT_DEBUG){
 			printf("preset: %d\n",ind);
 		}
 		cellData.backlog->add("loadPreset");
 	};
+	//halve world dimensions
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_MINUS(){
+		cellData.backlog->add("shrinkWorld");
+	};
+	//double world dimensions
+	template<typename Cell>
+	void InputHandlerT<Cell>::press_EQUALS(){
+		cellData.backlog->add("growWorld");
+	};
 
 
 
-void InputHandler::detectInput() {
+template<typename Cell>
+void InputHandlerT<Cell>::detectInput() {
 	holdAccel=1.0;
 	while(!QUIT_FLAG){
 		SDL_Event event;
@@ -400,7 +492,7 @@ void InputHandler::detectInput() {
 
 					// If the key combination is found, execute the associated function
 					if (it != keyFuncMap.end()) {
-						std::function<void(CAData&)>& func = it->second;
+						std::function<void(CADataT<Cell>&)>& func = it->second;
 						func(cellData);
 					}
 				}
@@ -469,7 +561,8 @@ void InputHandler::detectInput() {
 
 
 	//sdl window to world transform
-	std::array<double, 4> InputHandler::getWorldTransform() {
+	template<typename Cell>
+	std::array<double, 4> InputHandlerT<Cell>::getWorldTransform() {
 		int x, y;
 		SDL_GetWindowSize(SDLWindow, &x, &y );
 
@@ -502,7 +595,8 @@ void InputHandler::detectInput() {
 	}
 
 	//mouse world coordinates wrapped
-	std::array<int, 2> InputHandler::getWorldCursorPos() {
+	template<typename Cell>
+	std::array<int, 2> InputHandlerT<Cell>::getWorldCursorPos() {
 		auto offsetScale = getWorldTransform();
 		std::vector<float> worldCursorPos(2);
 
@@ -20,30 +20,40 @@
 
 /**
  * @brief Cellular Automata world OpenGL renderer
+ *
+ * @tparam Cell cellState cell type. 16-bit cells are uploaded as a 16-bit texture
 */
-class CARender {
+template<typename Cell>
+class CARenderT {
 private:
-    CAData &cellData;
-    InputHandler &kaeInput;
+    CADataT<Cell> &cellData;
+    InputHandlerT<Cell> &kaeInput;
     SDL_Window *&SDLWindow;  // Use reference to pointer
 
 public:
 	/**
 	 * @brief Initialize with reference injections
 	 * 
-	 * @param inCAData& CAData 
-	 * @param inInputHandler& InputHandler 
+	 * @param inCAData& CADataT<Cell> 
+	 * @param inInputHandler& InputHandlerT<Cell> 
 	 * @param inSDL_Window*& SDL_Window
 	*/
-    CARender(CAData &inCAData, InputHandler &inInputHandler, SDL_Window*& inSDL_Window)
+    CARenderT(CADataT<Cell> &inCAData, InputHandlerT<Cell> &inInputHandler, SDL_Window*& inSDL_Window)
         : cellData(inCAData), kaeInput(inInputHandler), SDLWindow(inSDL_Window) {}
 
 	// In initialization code
 	static GLuint textureID;
 	static GLuint shaderProgram;
+	static size_t textureRows; //allocated texture dimensions
+	static size_t textureCols;
 	void initOpenGL();
 
-	inline void renderWorld() {
+	/**
+	 * @brief Draw the world
+	 * 
+	 * @param frame published world to draw. If nullptr, cellState[mainCache.activeBuf] is drawn
+	*/
+	inline void renderWorld(const typename CAFrameBufferT<Cell>::Frame* frame = nullptr) {
 		const GLfloat quadVertices[] = {
 			-1.0f, -1.0f,
 			 1.0f, -1.0f,
@@ -58,7 +68,8 @@ public:
 		float shaderCursorPos[2];
 		shaderCursorPos[0]=worldCursorPos[0];
 		shaderCursorPos[1]=worldCursorPos[1];
-		uint numStates=cellData.kaePreset.current()->stateCount;
+		uint numStates = frame ? frame->stateCount : cellData.kaePreset.current()->stateCount; //preset may change while a frame is drawn
+		const CAGrid<Cell>& grid = frame ? frame->cells : cellData.cellState[cellData.mainCache.activeBuf];
 		float shaderDrawRadius  = (float)kaeInput.drawRadius;
 		float shaderCursorBorder= (float)cursorBorder;
 		float shaderShaderColor = kaeInput.shaderColor;
@@ -68,8 +79,8 @@ public:
 		
 
 		float shaderTileDim[2];
-		shaderTileDim[0]=cellData.mainCache.tileRows;
-		shaderTileDim[1]=cellData.mainCache.tileCols;
+		shaderTileDim[0]=grid.getRows(); //world may be resized while a frame is drawn
+		shaderTileDim[1]=grid.getCols();
 
 		std::swap(shaderTileDim  [1], shaderTileDim  [0]); //swap coordinates for glew
 		std::swap(shaderCursorPos[1], shaderCursorPos[0]);
@@ -99,7 +110,7 @@ public:
 		glOrtho(0, cellData.renderWidth, 0, cellData.renderHeight, -1, 1); // Set an orthographic projection
 
 		//copy cellState to texture
-		updateTexture(cellData);
+		updateTexture(grid);
 
 		glEnable(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, textureID);
@@ -116,23 +127,31 @@ public:
 	}
 
 private:
-	static void updateTexture(const CAData& cellData) {
-		uint activeRenderBuf = cellData.mainCache.activeBuf; // ensure buffer doesn't change during render
+	//texture formats of the cell type. 16-bit cells use a 16-bit red texture so every state keeps its own shade
+	static constexpr const GLint textureFormat = sizeof(Cell)==1 ? GL_LUMINANCE : GL_R16;
+	static constexpr const GLenum texturePixels = sizeof(Cell)==1 ? GL_LUMINANCE : GL_RED;
+	static constexpr const GLenum textureType = sizeof(Cell)==1 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
 
-		// allocate memory for pixelData
-		__attribute__((aligned(64))) uint8_t *pixelData = new uint8_t[cellData.mainCache.tileRows * cellData.mainCache.tileCols];
+	/**
+	 * @brief Upload cells to the world texture
+	*/
+	static void updateTexture(const CAGrid<Cell>& grid) {
+		glUniform1f(glGetUniformLocation(shaderProgram, "cellMax"), (float)CACellTraits<Cell>::maxCell); //texture reads cell/cellMax
+		glBindTexture(GL_TEXTURE_2D, textureID);
 
-		for (uint i = 0; i < cellData.mainCache.tileRows; ++i) {
-			const auto& row = cellData.cellState[activeRenderBuf].at(i);
-			std::memcpy(pixelData + i * cellData.mainCache.tileCols, row.data(), cellData.mainCache.tileCols);
+		if(grid.getRows()!=textureRows || grid.getCols()!=textureCols){ //world was resized
+			textureRows = grid.getRows();
+			textureCols = grid.getCols();
+			glTexImage2D(GL_TEXTURE_2D, 0, textureFormat, textureCols, textureRows, 0, texturePixels, textureType, nullptr);
 		}
-		
-		glBindTexture(GL_TEXTURE_2D, textureID);
 
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cellData.mainCache.tileCols, cellData.mainCache.tileRows, GL_LUMINANCE, GL_UNSIGNED_BYTE, pixelData);
+		//upload the padded grid directly. Row padding is skipped by GL_UNPACK_ROW_LENGTH
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, grid.getStride());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, grid.getCols(), grid.getRows(), texturePixels, textureType, grid.data());
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
 		glBindTexture(GL_TEXTURE_2D, 0);
-		delete[] pixelData;
 	}
 
 	//BOF Shader Parser
@@ -252,11 +271,17 @@ private:
 	//EOF Shader Parser
 };
 
+/** @brief Default 8-bit world renderer */
+typedef CARenderT<uint8_t> CARender;
+
 // Initialize static members
-GLuint CARender::textureID = 0;
-GLuint CARender::shaderProgram = 0;
+template<typename Cell> GLuint CARenderT<Cell>::textureID = 0;
+template<typename Cell> GLuint CARenderT<Cell>::shaderProgram = 0;
+template<typename Cell> size_t CARenderT<Cell>::textureRows = 0;
+template<typename Cell> size_t CARenderT<Cell>::textureCols = 0;
 
-void CARender::initOpenGL() {
+template<typename Cell>
+void CARenderT<Cell>::initOpenGL() {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 	glDepthMask(GL_TRUE);
@@ -267,7 +292,9 @@ void CARender::initOpenGL() {
 
 	glGenTextures(1, &textureID);
 	glBindTexture(GL_TEXTURE_2D, textureID);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, cellData.mainCache.tileCols, cellData.mainCache.tileRows, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
+	textureRows = cellData.mainCache.tileRows;
+	textureCols = cellData.mainCache.tileCols;
+	glTexImage2D(GL_TEXTURE_2D, 0, textureFormat, textureCols, textureRows, 0, texturePixels, textureType, nullptr);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
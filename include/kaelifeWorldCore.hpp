@@ -16,19 +16,77 @@
 #include <SDL2/SDL.h>
 #include <cmath>
 #include <vector>
+#include <atomic>
+#include <chrono>
 
 namespace kaelife {
 
+	/**
+	 * @brief Pipelined simulation loop. Dispatches tasks on its own generation clock and publishes each finished task to CAData::frames
+	 * 
+	 * Takes the place of main thread for CAData until stop is set: backlog runs here between tasks.
+	 * Render frame rate doesn't limit the generation rate, a task is only capped to about one targetFrameTime so input stays responsive
+	 * 
+	 * @param stop set by worldCore to return to coupled mode
+	*/
+	template<typename Cell>
+	void simulationCore(CADataT<Cell> &kaelife, InputHandlerT<Cell> &kaeInput, std::atomic<bool> &stop){
+		using simClock = std::chrono::steady_clock;
+		float iterAccumulate = 0; //due generations
+		float maxTask = 1; //generations that took about targetFrameTime last time
+		auto lastTime = simClock::now();
+
+		while (!stop && !kaeInput.QUIT_FLAG) {
+			auto now = simClock::now();
+			float elapsedMs = std::chrono::duration<float, std::milli>(now-lastTime).count();
+			lastTime = now;
+
+			uint iterTask = 0;
+			if(kaeInput.stepFrame){
+				iterTask = 1;
+				iterAccumulate = 0;
+				kaeInput.stepFrame = 0;
+			}else if(!kaeInput.pause){
+				iterAccumulate += elapsedMs/kaelife.targetFrameTime * kaeInput.simSpeed; //simSpeed generations per target frame
+				iterAccumulate = std::min(iterAccumulate, maxTask); //drop generations that can't be caught up
+				iterTask = iterAccumulate;
+				iterAccumulate -= iterTask;
+			}else{
+				iterAccumulate = 0;
+			}
+
+			if(iterTask>0){
+				auto taskStart = simClock::now();
+				kaelife.kaeMutex.continueThread(iterTask, kaelife.mainCache.activeBuf);
+				kaelife.syncMainThread();
+				float taskMs = std::chrono::duration<float, std::milli>(simClock::now()-taskStart).count();
+				kaelife.generation += iterTask;
+
+				float fitTask = taskMs>0 ? iterTask*kaelife.targetFrameTime/taskMs : 2*maxTask;
+				maxTask = std::max((maxTask+2*fitTask)/3.0f, 1.0f); //smooth by average
+			}
+
+			bool edited = kaelife.backlog->doBacklog(); //execute not-thread-safe-tasks thread-safely
+			if(iterTask>0 || edited){
+				kaelife.publishFrame();
+			}else{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1)); //no generation is due yet
+			}
+		}
+	}
+
 	/**
 	 * @brief Main iteration loop cycle and periodic updates 
 	 * 
 	*/
-	void worldCore(CAData &kaelife, CARender &kaeRender, InputHandler &kaeInput, SDL_Window *&SDLWindow){
+	template<typename Cell>
+	void worldCore(CADataT<Cell> &kaelife, CARenderT<Cell> &kaeRender, InputHandlerT<Cell> &kaeInput, SDL_Window *&SDLWindow){
 		std::vector<std::thread> iterThreads;
 
 		std::thread iterHandler = std::thread([&]() {
 			kaelife.startWorkerThreads(iterThreads);
 		});
+		kaelife.syncMainThread(); //workers may move cellState to their NUMA nodes before they first wait
 
 		std::thread inputThread = std::thread([&]() {
 			kaeInput.detectInput();
@@ -52,14 +110,34 @@ namespace kaelife {
 		float avgIters = 1000.0/kaelife.slowFrameTime;
 
 		float guessMaxIters = 1000.0/kaelife.slowFrameTime;
+
+		std::thread simThread; //runs simulationCore in pipelined mode
+		std::atomic<bool> simStop = 0;
+		bool simRunning = 0;
+		uint64_t lastGeneration = 0; //generation when frame time was printed
 		
 		while (!kaeInput.QUIT_FLAG) {
 
+			//threads are at waitResume here in coupled mode, and after simThread returns
+			if(kaeInput.pipelined!=simRunning){
+				if(simRunning){
+					simStop = 1;
+					simThread.join();
+				}else{
+					kaelife.publishFrame(); //first frame before the reader acquires
+					simStop = 0;
+					simThread = std::thread([&]() {
+						simulationCore(kaelife, kaeInput, simStop);
+					});
+				}
+				simRunning = !simRunning;
+			}
+
 			periodIndex++;
 			periodIndex%=periodSize;
 			periodIters[periodIndex]=0;
 			
-			if(!kaeInput.pause || kaeInput.stepFrame){
+			if(!simRunning && (!kaeInput.pause || kaeInput.stepFrame)){
 				if(kaeInput.stepFrame){
 					iterTask=1;
 					iterAccumulate=kaelife.targetFrameTime;
@@ -77,6 +155,7 @@ namespace kaelife {
 					}
 
 					kaelife.kaeMutex.continueThread(iterTask,kaelife.mainCache.activeBuf); //pass iteration count
+					kaelife.generation += iterTask;
 
 					float wholeIters=iterTask*kaelife.targetFrameTime; //Simulation time of whole iterations
 					iterAccumulate-=(float)wholeIters; //substract the iteration count passed to continueThread
@@ -87,7 +166,7 @@ namespace kaelife {
 			}
 			//pass previous buffer iteration to GPU while iterTask is being computed in new buffer
 			SDL_GL_SwapWindow(SDLWindow);
-			kaeRender.renderWorld();
+			kaeRender.renderWorld(simRunning ? &kaelife.frames.acquire() : nullptr);
 
 			do{ // Cap the frame rate
 				elapsedTime=SDL_GetTicks() - frameStartTime;
@@ -111,10 +190,15 @@ namespace kaelife {
 
 				if(kaeInput.displayFrameTime){
 					float itersPerSec = avgIters*(1000.0/avgTime) * !kaeInput.pause;
+					if(simRunning){ //generations don't follow frames
+						itersPerSec = (kaelife.generation-lastGeneration)*1000.0/lastframeTime;
+					}
 					printf("%f ms %f iter/s\n", avgTime, itersPerSec);
+					kaelife.printThreadTiming(); //work and barrier wait since last print
 					//printf("guess max %f\n", guessMaxIters);
 				}
 				lastframeTime=0;
+				lastGeneration=kaelife.generation;
 			}else{
 				//average current avg and previous value otherwise
 				avgTime =(avgTime *(periodSize-1)+elapsedTime				)/periodSize;
@@ -139,11 +223,17 @@ namespace kaelife {
 				}
 			}
 
-			kaelife.kaeMutex.syncMainThread(); //sync iterations
-			kaelife.backlog->doBacklog(); //execute not-thread-safe-tasks thread-safely
+			if(!simRunning){
+				kaelife.syncMainThread(); //sync iterations
+				kaelife.backlog->doBacklog(); //execute not-thread-safe-tasks thread-safely
+			}
 		}
 
 		//join any running threads
+		if(simRunning){
+			simStop = 1;
+			simThread.join();
+		}
 		kaelife.kaeMutex.terminateThread();
 		inputThread.join();
 		iterHandler.join();
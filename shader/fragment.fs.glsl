@@ -1,7 +1,6 @@
 #version 330 core
 #define M_PI 3.14159265358979323846
 #define M_TAU 6.28318530717958647693
-#define UINT8_MAX 255
 
 //example of header file that would be handled by processShaderSource() '//#include "path/to/source.h.glsl"'
 
@@ -13,6 +12,7 @@ uniform float cursorBorder;
 uniform float shaderColor;
 uniform float shaderHue;
 uniform float stateCount;
+uniform float cellMax; //largest value of the cell type, 255 or 65535
 
 uniform float colorStagger;
 
@@ -90,7 +90,7 @@ void main() {
 
 	float cellState = texture(textureSampler, texCoord).r;
 
-	float normalizedCellState = cellState*UINT8_MAX/(stateCount-1); // [0,stateCount/255] to [0,1]
+	float normalizedCellState = cellState*cellMax/(stateCount-1); // [0,stateCount/cellMax] to [0,1]
 
 	vec3 cellColor = vec3(normalizedCellState, normalizedCellState, normalizedCellState);
 	vec3 cursorColor = vec3(1.0, 0.0, 1.0);
@@ -25,11 +25,12 @@ namespace kaelife {
 #include <SDL2/SDL.h>
 #include <GL/glew.h>
 
-int main() {
-
-//	MasterConfig config("./config/"); //todo
-
-    CAData kaelife;
+/**
+ * @brief Open the window and run a world of Cell cells until exit
+*/
+template<typename Cell>
+int runWindow(uint worldRows, uint worldCols, uint64_t maxWorldBytes) {
+    CADataT<Cell> kaelife(worldRows, worldCols, maxWorldBytes);
 
     SDL_Window* mainSDLWindow;
     SDL_GLContext glContext = kaelife::initSDL(mainSDLWindow, kaelife.renderWidth, kaelife.renderHeight);
@@ -37,10 +38,10 @@ int main() {
         return -1;
     }
 
-    InputHandler kaeInput(kaelife, mainSDLWindow);
+    InputHandlerT<Cell> kaeInput(kaelife, mainSDLWindow);
 
 	CADraw kaeDraw;
-    CARender kaeRender(kaelife, kaeInput, mainSDLWindow);
+    CARenderT<Cell> kaeRender(kaelife, kaeInput, mainSDLWindow);
  
 	kaeRender.initOpenGL();
 
@@ -59,6 +60,22 @@ int main() {
 	return 0;
 }
 
+int main(int argc, char** argv) {
+
+//	MasterConfig config("./config/"); //todo
+
+	//optional world dimensions, cell width and world buffer cap: kaelifecpp [rows] [cols] [8|16] [maxMiB]
+	uint worldRows = argc>1 ? std::max(atoi(argv[1]), 1) : CAData::defaultRows;
+	uint worldCols = argc>2 ? std::max(atoi(argv[2]), 1) : CAData::defaultCols;
+	uint cellBits = argc>3 ? atoi(argv[3]) : 8;
+	uint64_t maxWorldBytes = argc>4 ? strtoull(argv[4], nullptr, 10)<<20 : 0; //0 uses CAData default
+	if(cellBits!=8 && cellBits!=16){
+		printf("Usage: %s [rows] [cols] [8|16] [maxMiB]\n", argv[0]);
+		return 1;
+	}
+	return cellBits==16 ? runWindow<uint16_t>(worldRows, worldCols, maxWorldBytes) : runWindow<uint8_t>(worldRows, worldCols, maxWorldBytes);
+}
+
 //benchmarking , needs -g flag
 //valgrind --tool=callgrind ./build/kaelifecpp_OPTIMIZED
 //
@@ -0,0 +1,114 @@
+/**
+ * @file caCellBench.cpp
+ *
+ * @brief Single threaded throughput of 8-bit CAData against 16-bit CAData16 per preset
+ *
+ * Presets that fit 8 bits iterate the same random world in both widths and the world hash is compared,
+ * so the cost of twice the bytes per cell is measured on identical work. 16-bit only presets run CAData16 alone.
+ * GB/s counts one read and one write of every cell per generation.
+ * Build: sh CMakeBuild.sh ALL OPTIMIZED ./tools, or without SDL2: sh CMakeBuild.sh ACTIVE OPTIMIZED ./tools caCellBench HEADLESS
+ * Run: ./build/caCellBench_OPTIMIZED [generations] [rows] [cols] [preset index]
+*/
+
+#include "kaelRandom.hpp"
+
+namespace kaelife {
+	KaelRandom<uint64_t>rand;
+	constexpr bool CA_DEBUG = 0;
+	constexpr bool INPUT_DEBUG = 0;
+}
+
+#include "CA/kaelifeCAData.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+//FNV-1a of world cell values, equal in both widths for equal worlds
+template<typename Cell>
+uint64_t hashWorld(CAGrid<Cell> &grid){
+	uint64_t hash = 1469598103934665603ull;
+	for(size_t x=0;x<grid.getRows();x++){
+		for(size_t y=0;y<grid.getCols();y++){
+			hash = (hash^grid[x][y])*1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+//Iterate whole world like a single iterateWorld thread
+template<typename Cell>
+double benchCells(CADataT<Cell> &kaeData, CAKernel::KernelType kernel, uint generations, uint64_t seed, uint64_t *hash){
+	kaeData.kernelPreference = kernel;
+	kaeData.loadPreset();
+	kaeData.randState(kaeData.mainCache.stateCount, &seed);
+	kaeData.cloneBuffer();
+
+	typename CADataT<Cell>::ThreadCache lv = kaeData.mainCache;
+	kaeData.kaeCache.copyCache(&lv, kaeData.mainCache);
+	lv.threadId = 0;
+
+	CABarrier localBarrier(1);
+	auto start = std::chrono::steady_clock::now();
+	kaeData.iterateTask(lv, localBarrier, generations, 0, lv.tileRows);
+	auto end = std::chrono::steady_clock::now();
+
+	*hash = hashWorld(kaeData.cellState[lv.activeBuf]);
+	return std::chrono::duration<double, std::milli>(end-start).count();
+}
+
+//index of the 8-bit preset with the same rules as wide preset, UINT_MAX if none. Randomized presets differ between widths
+uint narrowIndex(CAData &narrow, const CAPresetT<uint16_t>::RulePreset &preset){
+	for(uint p=0;narrow.kaePreset.setPreset(p)==p;p++){
+		const CAPreset::RulePreset &candidate = *narrow.kaePreset.current();
+		if(candidate.name==preset.name && candidate.stateCount==preset.stateCount
+			&& std::equal(candidate.ruleRange.begin(), candidate.ruleRange.end(), preset.ruleRange.begin(), preset.ruleRange.end())
+			&& std::equal(candidate.ruleAdd.begin(), candidate.ruleAdd.end(), preset.ruleAdd.begin(), preset.ruleAdd.end())){
+			return p;
+		}
+	}
+	return UINT_MAX;
+}
+
+void printRun(const char* width, uint kernel, uint resolved, double ms, double cells, size_t cellBytes){
+	printf("  %-6s %-7s -> %-7s %9.2f ms %8.2f Mcell/s %6.2f GB/s", width, CAKernel::kernelName[kernel], CAKernel::kernelName[resolved], ms,
+		cells/ms/1000.0, cells*2*cellBytes/ms/1e6);
+}
+
+int main(int argc, char** argv) {
+	uint generations = argc>1 ? atoi(argv[1]) : 20;
+	uint rows = argc>2 ? atoi(argv[2]) : 2048;
+	uint cols = argc>3 ? atoi(argv[3]) : 2048;
+	int onlyPreset = argc>4 ? atoi(argv[4]) : -1;
+
+	CAData narrow(rows, cols);
+	CAData16 wide(rows, cols);
+
+	const double cells = (double)wide.mainCache.tileRows*wide.mainCache.tileCols*generations;
+	printf("%ux%u world, %u generations, %lu KiB 8-bit, %lu KiB 16-bit per buffer\n", wide.mainCache.tileRows, wide.mainCache.tileCols, generations,
+		(size_t)rows*cols/1024, (size_t)rows*cols*sizeof(uint16_t)/1024);
+
+	const CAKernel::KernelType kernels[] = {CAKernel::KERNEL_SCALAR, CAKernel::KERNEL_BOX, CAKernel::KERNEL_AUTO};
+	for(uint p=0;wide.kaePreset.setPreset(p)==p;p++){ //setPreset wraps to 0 past the last preset
+		if(onlyPreset>=0 && (uint)onlyPreset!=p){continue;}
+		const uint np = narrowIndex(narrow, *wide.kaePreset.current());
+		printf("%s, %u states\n", wide.kaePreset.current()->name.c_str(), wide.kaePreset.current()->stateCount);
+
+		for(CAKernel::KernelType kernel : kernels){
+			uint64_t narrowHash = 0, wideHash = 0;
+			double narrowMs = 0.0;
+			if(np!=UINT_MAX){
+				narrow.kaePreset.setPreset(np);
+				narrowMs = benchCells(narrow, kernel, generations, 12345+p, &narrowHash);
+				printRun("8-bit", kernel, narrow.mainCache.kernel, narrowMs, cells, sizeof(uint8_t));
+				printf("\n");
+			}
+			double wideMs = benchCells(wide, kernel, generations, 12345+p, &wideHash);
+			printRun("16-bit", kernel, wide.mainCache.kernel, wideMs, cells, sizeof(uint16_t));
+			if(np!=UINT_MAX){
+				printf(" %5.2fx %s", wideMs/narrowMs, wideHash==narrowHash ? "" : "HASH MISMATCH");
+			}
+			printf("\n");
+		}
+	}
+	return 0;
+}
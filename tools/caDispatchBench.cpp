@@ -0,0 +1,95 @@
+/**
+ * @file caDispatchBench.cpp
+ *
+ * @brief CALock dispatch latency and CABarrier generation latency per thread count
+ *
+ * Threads run the same waitResume loop as CAData::iterateWorld without iterating cells,
+ * so the times are the synchronization cost that every task and every generation pays.
+ * Build: sh CMakeBuild.sh ALL OPTIMIZED ./tools, or without SDL2: sh CMakeBuild.sh ACTIVE OPTIMIZED ./tools caDispatchBench HEADLESS
+ * Run: ./build/caDispatchBench_OPTIMIZED [max threads] [rounds] [generations per task]
+*/
+
+#include "kaelRandom.hpp"
+
+namespace kaelife {
+	KaelRandom<uint64_t>rand;
+	constexpr bool CA_DEBUG = 0;
+	constexpr bool INPUT_DEBUG = 0;
+}
+
+#include "CA/kaelifeCAData.hpp"
+
+#include <chrono>
+
+struct DispatchTime{
+	double median; //microseconds
+	double p99;
+};
+
+//Median and 99th percentile of samples in microseconds
+DispatchTime summarize(std::vector<double> &samples){
+	std::sort(samples.begin(), samples.end());
+	return {samples[samples.size()/2], samples[samples.size()*99/100]};
+}
+
+//Time main thread continueThread to syncMainThread round trips of threadCount threads
+void benchDispatch(uint threadCount, uint rounds, uint generations, DispatchTime *dispatch, DispatchTime *generation){
+	CALock lock;
+	CABarrier barrier(threadCount);
+	lock.expectedThreadCount(threadCount);
+
+	std::vector<std::thread> threads;
+	for(uint i=0;i<threadCount;i++){
+		threads.emplace_back([&, i]() {
+			uint iterTask = 0;
+			bool activeBuf = 0;
+			while(1){
+				lock.waitResume(i, &iterTask, &activeBuf);
+				if(lock.isThreadTerminated){ break; }
+				for(uint g=0;g<iterTask;g++){
+					barrier.arrive_and_wait();
+				}
+			}
+		});
+	}
+	lock.syncMainThread();
+
+	std::vector<double> emptySamples;
+	std::vector<double> genSamples;
+	for(uint r=0;r<rounds;r++){
+		auto start = std::chrono::steady_clock::now();
+		lock.continueThread(0, 0);
+		lock.syncMainThread();
+		auto mid = std::chrono::steady_clock::now();
+		lock.continueThread(generations, 0);
+		lock.syncMainThread();
+		auto end = std::chrono::steady_clock::now();
+
+		const double emptyUs = std::chrono::duration<double, std::micro>(mid-start).count();
+		emptySamples.push_back(emptyUs);
+		genSamples.push_back(std::max(std::chrono::duration<double, std::micro>(end-mid).count()-emptyUs, 0.0)/generations);
+	}
+
+	lock.terminateThread();
+	for(std::thread &thread : threads){
+		thread.join();
+	}
+	*dispatch = summarize(emptySamples);
+	*generation = summarize(genSamples);
+}
+
+int main(int argc, char** argv) {
+	uint maxThreads = argc>1 ? std::max(atoi(argv[1]),1) : std::max(std::thread::hardware_concurrency(),1u);
+	uint rounds = argc>2 ? std::max(atoi(argv[2]),1) : 2000;
+	uint generations = argc>3 ? std::max(atoi(argv[3]),1) : 16;
+
+	printf("%u rounds, %u generations per task, %u hardware threads\n", rounds, generations, std::thread::hardware_concurrency());
+	printf("threads  dispatch median   p99 us  generation median   p99 us\n");
+	for(uint threadCount=1;threadCount<=maxThreads;threadCount = threadCount<maxThreads ? std::min(threadCount*2, maxThreads) : threadCount+1){
+		DispatchTime dispatch;
+		DispatchTime generation;
+		benchDispatch(threadCount, rounds, generations, &dispatch, &generation);
+		printf("%7u  %15.2f %8.2f  %17.2f %8.2f\n", threadCount, dispatch.median, dispatch.p99, generation.median, generation.p99);
+	}
+	return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file caKernelBench.cpp
+ *
+ * @brief Single threaded CAKernel throughput per preset
+ *
+ * Every kernel iterates the same random world for the same generations and the world hash is compared,
+ * so a faster kernel that disagrees is reported.
+ * Build: sh CMakeBuild.sh ALL OPTIMIZED ./tools, or without SDL2: sh CMakeBuild.sh ACTIVE OPTIMIZED ./tools caKernelBench HEADLESS
+ * Run: ./build/caKernelBench_OPTIMIZED [generations] [preset index] [fill percent] [temporal depth]
+ * Fill percent below 100 randomizes only a centered square of that area, rest of the world is empty
+ * Temporal depth above 1 iterates that many generations per tile between barriers
+*/
+
+#include "kaelRandom.hpp"
+
+namespace kaelife {
+	KaelRandom<uint64_t>rand;
+	constexpr bool CA_DEBUG = 0;
+	constexpr bool INPUT_DEBUG = 0;
+}
+
+#include "CA/kaelifeCAData.hpp"
+
+#include <chrono>
+
+//FNV-1a of world cells
+uint64_t hashWorld(CAGrid<uint8_t> &grid){
+	uint64_t hash = 1469598103934665603ull;
+	for(size_t x=0;x<grid.getRows();x++){
+		for(size_t y=0;y<grid.getCols();y++){
+			hash = (hash^grid[x][y])*1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+//Iterate whole world like a single iterateWorld thread
+double benchKernel(CAData &kaeData, CAKernel::KernelType kernel, uint generations, uint fillPercent, uint temporalDepth, uint64_t seed, uint64_t *hash){
+	kaeData.kernelPreference = kernel;
+	kaeData.loadPreset();
+	kaeData.mainCache.temporalDepth = temporalDepth;
+	kaeData.randState(kaeData.mainCache.stateCount, &seed);
+
+	//clear everything outside the filled square
+	CAGrid<uint8_t> &grid = kaeData.cellState[kaeData.mainCache.activeBuf];
+	double side = std::sqrt(std::min(fillPercent,100u)/100.0);
+	uint fillRows = grid.getRows()*side;
+	uint fillCols = grid.getCols()*side;
+	uint x0 = (grid.getRows()-fillRows)/2;
+	uint y0 = (grid.getCols()-fillCols)/2;
+	for(uint x=0;x<grid.getRows();x++){
+		for(uint y=0;y<grid.getCols();y++){
+			bool inside = x>=x0 && x<x0+fillRows && y>=y0 && y<y0+fillCols;
+			grid[x][y] = inside ? grid[x][y] : 0;
+		}
+	}
+	kaeData.cloneBuffer();
+
+	CACache::ThreadCache lv = kaeData.mainCache;
+	kaeData.kaeCache.copyCache(&lv, kaeData.mainCache);
+	lv.threadId = 0;
+
+	CABarrier localBarrier(1);
+	auto start = std::chrono::steady_clock::now();
+	kaeData.iterateTask(lv, localBarrier, generations, 0, lv.tileRows);
+	auto end = std::chrono::steady_clock::now();
+
+	*hash = hashWorld(kaeData.cellState[lv.activeBuf]);
+	return std::chrono::duration<double, std::milli>(end-start).count();
+}
+
+int main(int argc, char** argv) {
+	uint generations = argc>1 ? atoi(argv[1]) : 100;
+	int onlyPreset = argc>2 ? atoi(argv[2]) : -1;
+	uint fillPercent = argc>3 ? atoi(argv[3]) : 100;
+	uint temporalDepth = argc>4 ? std::max(atoi(argv[4]),1) : 1;
+
+	CAData kaeData;
+	uint cellCount = kaeData.mainCache.tileRows*kaeData.mainCache.tileCols;
+	printf("%ux%u world, %u%% filled, %u generations, %u per tile, SIMD: %s\n", kaeData.mainCache.tileRows, kaeData.mainCache.tileCols, fillPercent, generations,
+		temporalDepth, CAKernel::simdName[CAKernel::simdLevel()]);
+
+	for(uint p=0;kaeData.kaePreset.setPreset(p)==p;p++){ //setPreset wraps to 0 past the last preset
+		if(onlyPreset>=0 && (uint)onlyPreset!=p){continue;}
+		printf("%s\n", kaeData.kaePreset.current()->name.c_str());
+
+		double baseTime = 0.0;
+		uint64_t baseHash = 0;
+		for(uint k=CAKernel::KERNEL_SCALAR;k<CAKernel::KERNEL_COUNT;k++){
+			if(k==CAKernel::KERNEL_HASHLIFE || k==CAKernel::KERNEL_CHUNKED){continue;} //unbounded planes don't wrap like the others
+			uint64_t hash = 0;
+			double ms = benchKernel(kaeData, (CAKernel::KernelType)k, generations, fillPercent, temporalDepth, 12345+p, &hash);
+			if(k==CAKernel::KERNEL_SCALAR){
+				baseTime = ms;
+				baseHash = hash;
+			}
+			printf("  %-7s -> %-7s %9.2f ms %8.2f Mcell/s %5.2fx %s\n",
+				CAKernel::kernelName[k], CAKernel::kernelName[kaeData.mainCache.kernel], ms,
+				(double)cellCount*generations/ms/1000.0, baseTime/ms, hash==baseHash ? "" : "HASH MISMATCH");
+		}
+	}
+	return 0;
+}